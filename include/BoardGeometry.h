@@ -0,0 +1,29 @@
+#ifndef BOARDGEOMETRY_H
+#define BOARDGEOMETRY_H
+
+#include <cstdint>
+
+// squares are bits 0 to 31, four to a row starting from o's back rank, and up is the way o moves.
+// the one place the board's shape is written down, everything that steps pieces around uses it
+
+// squares of the rows that start one column in, whose up and down neighbours are one bit closer
+const uint32_t EVEN_MASK = 252645135;
+const uint32_t ROW_END_MASK = 4026531855;
+const uint32_t O_BACK_RANK = 15;
+const uint32_t X_BACK_RANK = 4026531840;
+const uint32_t L_COL_MASK = 16843009;
+const uint32_t R_COL_MASK = 2155905152;
+
+// shift every piece one square diagonally at once, dropping pieces that would leave the board
+constexpr uint32_t shift(uint32_t pieces, bool left, bool up)
+{
+    pieces &= left ? ~L_COL_MASK : ~R_COL_MASK;
+
+    const uint32_t even = pieces & EVEN_MASK, odd = pieces & ~EVEN_MASK;
+    if (up)
+        return left ? (even << 3) | (odd << 4) : (even << 4) | (odd << 5);
+    else
+        return left ? (even >> 5) | (odd >> 4) : (even >> 4) | (odd >> 3);
+}
+
+#endif // BOARDGEOMETRY_H
@@ -0,0 +1,67 @@
+#ifndef ENDGAMEDB_H
+#define ENDGAMEDB_H
+
+#include <cstdint>
+#include <string>
+#include "MappedFile.h"
+
+// most pieces on the board, both sides together, any database can hold
+#define MAX_EG_PIECES 6
+
+using namespace std;
+
+enum EGResult { EG_UNKNOWN, EG_DRAW, EG_WIN, EG_LOSS };
+
+// board is {uint32_t x_board, uint32_t o_board, uint32_t kings}
+//
+// A database is split into slices, one for every count of x men, x kings, o men and o kings.
+// Inside a slice every group of pieces is ranked as a combination of squares, men only over the 28
+// squares they can stand on, and the ranks are combined into an index with x to move first, then o.
+// Each position takes one byte: 0 is a draw, otherwise the byte is one more than the number of
+// plies until the losing side has no move left, so an odd distance is a win for the side to move
+
+class EndgameDB
+{
+    public:
+        struct Header {
+            char magic[8];
+            uint32_t max_pieces;
+            uint32_t slice_count;
+        };
+
+        struct Slice {
+            uint8_t x_men, x_kings, o_men, o_kings;
+            uint32_t reserved;
+            uint64_t offset;
+            uint64_t positions;
+        };
+
+        static const char MAGIC[8];
+
+        EndgameDB();
+        virtual ~EndgameDB();
+
+        bool open(const string& path);
+        void close();
+
+        bool is_open() const { return file.is_open(); }
+        int max_pieces() const { return pieces; }
+
+        EGResult probe(const uint32_t board[], bool is_o, int& distance) const;
+
+        static uint64_t choose(int n, int k);
+        static uint64_t slice_positions(int x_men, int x_kings, int o_men, int o_kings);
+        static uint64_t position_index(const uint32_t board[]);
+        static uint8_t encode(EGResult result, int distance);
+        static EGResult decode(uint8_t value, int& distance);
+
+    private:
+        MappedFile file;
+        int pieces = 0;
+        const uint8_t* slices[MAX_EG_PIECES + 1][MAX_EG_PIECES + 1][MAX_EG_PIECES + 1][MAX_EG_PIECES + 1];
+        uint64_t slice_sizes[MAX_EG_PIECES + 1][MAX_EG_PIECES + 1][MAX_EG_PIECES + 1][MAX_EG_PIECES + 1];
+
+        static uint64_t rank(uint32_t squares, int offset);
+};
+
+#endif // ENDGAMEDB_H
@@ -0,0 +1,53 @@
+#ifndef EVALUATION_H
+#define EVALUATION_H
+
+#include <cstdint>
+#include <string>
+
+using namespace std;
+
+// weights in hundredths of a point, a man is worth 3 points and a king 5 as in the old material count
+struct EvalWeights {
+    int man = 300;
+    int king = 500;
+    int back_rank = 20;      // man still guarding its own back rank
+    int center = 10;         // man or king on one of the middle squares
+    int advance = 4;         // every row a man has moved up
+    int king_mobility = 3;   // every empty square a king can step to
+};
+
+// board is {uint32_t x_board, uint32_t o_board, uint32_t kings}
+
+// everything but mobility comes from per square tables, so a move changes the score by the
+// squares it touches and the search carries the score down like the zobrist hash.
+// scores are from x's point of view
+class Evaluation
+{
+    public:
+        Evaluation();
+        Evaluation(const EvalWeights& weights);
+        virtual ~Evaluation();
+
+        void set_weights(const EvalWeights& weights);
+        const EvalWeights& get_weights() const { return weights; }
+
+        int score(const uint32_t board[]) const;
+        int mobility(const uint32_t board[]) const;
+
+        // piece is 0 to 3 for x men, o men, x kings and o kings
+        int square_score(int piece, int square) const { return table[piece][square]; }
+
+        // a weights file has one "name value" line per weight, as written by the Tuner target
+        static bool load_weights(const string& path, EvalWeights& weights);
+        static bool save_weights(const string& path, const EvalWeights& weights);
+
+    private:
+        EvalWeights weights;
+
+        // x men, o men, x kings and o kings on every square, o's share already negated
+        int table[4][32];
+
+        int score_pieces(int piece, uint32_t pieces) const;
+};
+
+#endif // EVALUATION_H
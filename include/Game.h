@@ -0,0 +1,83 @@
+#ifndef GAME_H
+#define GAME_H
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include "PlayerAI.h"
+
+#define O_PIECE 'O'
+#define X_PIECE 'X'
+#define O_KING '@'
+#define X_KING '#'
+#define SPACE '*'
+
+using namespace std;
+
+// board is {uint32_t x_board, uint32_t o_board, uint32_t kings}
+
+// one game with its own board and engine, the player moves a piece one step or jump at a time as in the console game,
+// so any number of games can run side by side
+class Game
+{
+    public:
+        Game();
+        // games that pass the same table share what their searches found
+        Game(shared_ptr<TranspositionTable> table);
+
+        PlayerAI& engine() { return *playerAI; }
+
+        uint32_t o_board() { return this->board[1]; }
+        uint32_t x_board() { return this->board[0]; }
+        uint32_t kings() { return this->board[2]; }
+        bool is_o_turn() { return this->o_turn; }
+        char turn_char();
+
+        // O_PIECE or X_PIECE once a side has won, SPACE before that
+        char winner();
+
+        // after a jump the same piece may jump again, captures are [any, lf, rf, lb, rb] with left and forward first
+        bool capturing() { return next_capture[0]; }
+        const bool* capture_options() { return next_capture; }
+
+        // the methods taking input return what was wrong with it, empty when it was played
+        string select_piece(int row, int col);
+        bool selected_king() { return (piece_pos & board[2]) != 0; }
+        string move_selected(bool left, bool forward);
+        string continue_capture(bool left, bool forward);
+        void finish_capture();
+
+        // plays the side to move, pondering keeps the engine searching on the reply it expects
+        uint32_t engine_move(bool ponder);
+
+        string board_string();
+
+        // row and column as typed in the game, e.g. 3,2
+        static string square_name(uint32_t pos);
+        static string move_name(uint32_t move, uint32_t player, uint32_t opponent);
+
+    private:
+        uint32_t board[3] = { 4293918720, 4095, 0 };
+
+        bool o_turn = true;
+        bool o_wins = false, x_wins = false;
+        uint32_t piece_pos = 0;
+        bool next_capture[5] = { false, false, false, false, false };
+
+        unique_ptr<PlayerAI> playerAI;
+
+        bool is_space(uint32_t pos);
+        static char get_king_side(char king);
+        bool same_side(uint32_t pos, char piece);
+        void add_piece(bool is_o, uint32_t pos, bool is_king);
+        void remove_piece(bool is_o, uint32_t pos);
+        uint32_t move(uint32_t pos, bool left, bool forward, bool o_turn);
+        uint32_t move(uint32_t pos, bool left, bool forward);
+        char get_piece(uint32_t pos);
+        void available_captures(bool* captures, uint32_t pos);
+        bool has_move(uint32_t pos);
+        bool is_winner(bool o_turn);
+        void change_turn();
+};
+
+#endif // GAME_H
@@ -0,0 +1,77 @@
+#ifndef GAMESERVER_H
+#define GAMESERVER_H
+
+#include <cstdint>
+#include <string>
+#include <memory>
+#include <map>
+#include <deque>
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <atomic>
+#include <condition_variable>
+#include "Game.h"
+
+using namespace std;
+
+// hosts one game per connection on a local unix socket. The polling thread accepts clients and splits what they send
+// into lines, a pool of workers plays them, and a game only ever runs on one worker at a time
+class GameServer
+{
+    public:
+        // with a shared table size of 0 every game gets a table of its own. A shared table's age goes up whenever any
+        // game starts a search, so with many games at once entries are replaced sooner than one game alone would
+        // replace them, which favours the positions of the games that are being played right now
+        GameServer(const string& path, int threads, SearchLimits limits, size_t shared_table_mb);
+        virtual ~GameServer();
+
+        // size of each game's own table when there is no shared one, for games that connect after this
+        void set_session_table_size(size_t size_mb) { session_table_mb = size_mb; }
+
+        bool load_endgame_db(const string& path) { return databases->load_endgame_db(path); }
+        bool load_opening_book(const string& path) { return databases->load_opening_book(path); }
+        bool load_weights(const string& path) { return databases->load_weights(path); }
+
+        // blocks until stop is called, false if the socket could not be opened
+        bool run();
+        void stop() { running = false; }
+
+    private:
+        struct Session {
+            int fd;
+            unique_ptr<Game> game;
+            string input;
+            deque<string> lines;
+            bool busy = false;
+            bool closed = false;
+        };
+
+        string path;
+        int threads;
+        SearchLimits limits;
+        size_t session_table_mb;
+        shared_ptr<TranspositionTable> table;
+        // only holds the endgame database, opening book and weights that every game's engine shares
+        unique_ptr<PlayerAI> databases;
+
+        int listen_fd = -1;
+        atomic<bool> running { false };
+
+        // sessions, their lines and the queue are guarded by one lock, searches run outside it
+        mutex lock;
+        condition_variable work_ready;
+        map<int, shared_ptr<Session>> sessions;
+        deque<shared_ptr<Session>> work;
+        vector<thread> workers;
+
+        bool remove_socket();
+        void accept_client();
+        void read_client(shared_ptr<Session> session);
+        void close_session(shared_ptr<Session> session);
+        void worker();
+        string play(Session& session, const string& line);
+        string state(Game& game);
+};
+
+#endif // GAMESERVER_H
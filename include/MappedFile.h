@@ -0,0 +1,37 @@
+#ifndef MAPPEDFILE_H
+#define MAPPEDFILE_H
+
+#include <cstdint>
+#include <cstddef>
+#include <string>
+
+using namespace std;
+
+// read-only view of a whole file mapped into memory, pages are loaded by the os on first access
+class MappedFile
+{
+    public:
+        MappedFile();
+        virtual ~MappedFile();
+
+        MappedFile(const MappedFile&) = delete;
+        MappedFile& operator=(const MappedFile&) = delete;
+
+        bool open(const string& path);
+        void close();
+
+        bool is_open() const { return bytes != nullptr; }
+        const uint8_t* data() const { return bytes; }
+        size_t size() const { return length; }
+
+    private:
+        const uint8_t* bytes = nullptr;
+        size_t length = 0;
+
+#ifdef _WIN32
+        void* file_handle = nullptr;
+        void* mapping_handle = nullptr;
+#endif
+};
+
+#endif // MAPPEDFILE_H
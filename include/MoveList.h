@@ -0,0 +1,48 @@
+#ifndef MOVELIST_H
+#define MOVELIST_H
+
+#include <cstdint>
+#include <cassert>
+#include <utility>
+
+// a piece's moves all end on different squares, since only the longest capture between two squares is listed, and
+// those are empty squares or its own square at the end of a capture loop. So a side with p pieces has at most
+// p * (e + 1) moves for e empty squares. Captures need an opponent piece, so p + e <= 31, and with the 12 pieces a
+// side starts with that is 12 * 20 = 240. Without captures it is at most 4 moves a piece, 48
+#define MAX_MOVES 256
+
+// fixed capacity list of encoded moves, lives on the stack or in a preallocated ply stack
+struct MoveList {
+    uint32_t moves[MAX_MOVES];
+    int scores[MAX_MOVES];
+    int count = 0;
+
+    void push_back(uint32_t move)
+    {
+        assert(count < MAX_MOVES);
+        moves[count++] = move;
+    }
+    void clear() { count = 0; }
+
+    int size() const { return count; }
+    bool empty() const { return count == 0; }
+
+    // selection sort one step at a time, since a cutoff usually comes before the list is exhausted
+    uint32_t pick(int i)
+    {
+        int best = i;
+        for (int j = i + 1; j < count; j++)
+            if (scores[j] > scores[best])
+                best = j;
+
+        std::swap(moves[i], moves[best]);
+        std::swap(scores[i], scores[best]);
+        return moves[i];
+    }
+
+    uint32_t& operator[](int i) { return moves[i]; }
+    uint32_t* begin() { return moves; }
+    uint32_t* end() { return moves + count; }
+};
+
+#endif // MOVELIST_H
@@ -0,0 +1,46 @@
+#ifndef OPENINGBOOK_H
+#define OPENINGBOOK_H
+
+#include <cstdint>
+#include <string>
+#include "MappedFile.h"
+
+using namespace std;
+
+// A book is a header followed by entries sorted by the zobrist hash of the position, with the
+// side to move, so a lookup is a binary search straight over the mapped file
+
+class OpeningBook
+{
+    public:
+        struct Header {
+            char magic[8];
+            uint64_t count;
+        };
+
+        struct Entry {
+            uint64_t key;
+            uint32_t move;
+            float score;
+        };
+
+        static const char MAGIC[8];
+
+        OpeningBook();
+        virtual ~OpeningBook();
+
+        bool open(const string& path);
+        void close();
+
+        bool is_open() const { return file.is_open(); }
+        uint64_t size() const { return count; }
+
+        bool probe(uint64_t key, Entry& entry) const;
+
+    private:
+        MappedFile file;
+        const Entry* entries = nullptr;
+        uint64_t count = 0;
+};
+
+#endif // OPENINGBOOK_H
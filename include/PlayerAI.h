@@ -1,8 +1,29 @@
 #ifndef PLAYERAI_H
 #define PLAYERAI_H
 
+#include <cstdint>
+#include <chrono>
+#include <atomic>
+#include <memory>
+#include <thread>
+#include <mutex>
+#include <future>
+#include <functional>
 #include <vector>
-#include <unordered_map>
+#include <utility>
+#include "MoveList.h"
+#include "TranspositionTable.h"
+#include "EndgameDB.h"
+#include "OpeningBook.h"
+#include "Evaluation.h"
+#include "SearchStats.h"
+#include "BoardGeometry.h"
+
+// deepest ply the search keeps a preallocated move list for
+#define MAX_PLY 64
+
+// score of a position the endgame database knows to be won, less one for every ply until the win
+#define EG_WIN_SCORE 1000
 
 using namespace std;
 
@@ -11,44 +32,212 @@ struct ScoreMovePair {
     float score;
 };
 
+// what make_move changed, enough for unmake_move to put the board, hash and evaluation back
+struct UndoRecord {
+    uint32_t captures;
+    uint32_t captured_kings;
+    bool promoted;
+    uint64_t hash;
+    int eval;
+};
+
+// one of the best root moves with its score and the line the search expects after it, starting with the move
+struct RootLine {
+    uint32_t move;
+    float score;
+    vector<uint32_t> pv;
+};
+
+// minimax and plain alpha-beta are kept to compare node counts against, pvs is the default
+enum SearchAlgorithm : uint8_t { SEARCH_MINIMAX, SEARCH_ALPHABETA, SEARCH_PVS };
+
+// late move reductions search quiet moves from the lmr_moves-th on lmr_reduction plies shallower once depth reaches
+// lmr_depth, and search them again at full depth if they beat alpha. futility pruning skips quiet moves within
+// futility_depth of the leaves when the static score is more than futility_margin points a ply short of the window
+struct Selectivity {
+    bool lmr;
+    int lmr_depth;
+    int lmr_moves;
+    int lmr_reduction;
+    bool futility;
+    int futility_depth;
+    float futility_margin;
+};
+
+// a limit of 0 is not enforced, the search stops at whichever limit is reached first
+struct SearchLimits {
+    int depth;
+    int time_ms;
+    uint64_t nodes;
+};
+
+// what start_search's future gives, depth is that of the deepest finished iteration and 0 for a book move
+struct SearchResult {
+    uint32_t move;
+    float score;
+    int depth;
+    // stop_search was called before the search finished
+    bool cancelled;
+};
+
+// called on the search thread after every finished iteration
+typedef function<void(const IterationStats&)> ProgressCallback;
+
 // board is {uint32_t x_board, uint32_t o_board, uint32_t kings}
 
 class PlayerAI
 {
+    // times the private move generation and evaluation primitives in tools/benchmark.cpp
+    friend class PrimitiveBenchmark;
+
     public:
         PlayerAI(uint32_t o_board, uint32_t x_board, uint32_t kings);
+        // engines that pass the same table search through each other's entries, as the lazy smp helpers do
+        PlayerAI(uint32_t o_board, uint32_t x_board, uint32_t kings, shared_ptr<TranspositionTable> table);
         virtual ~PlayerAI();
 
-        void minimax(int depth, bool max_player);
-        void alphabeta(int depth, bool max_player);
+        // call after a move has been played for max_player, the next next_move stops or takes over the search
+        void start_pondering(bool max_player);
+        void stop_pondering();
+
+        // move generation for tools that work on {x_board, o_board, kings} boards
+        void generate_moves(uint32_t board[], bool is_o, MoveList& moves) { get_all_moves(board, is_o, moves); }
+        void apply_move(uint32_t board[], uint32_t new_board[], uint32_t move, bool is_o) { simulate_move(board, new_board, move, is_o, true); }
+
+        uint64_t perft(uint32_t o_board, uint32_t x_board, uint32_t kings, bool o_turn, int depth, vector<pair<uint32_t, uint64_t>>* divide = nullptr);
 
         void next_move(bool player, uint32_t o_board, uint32_t x_board, uint32_t kings, bool o_wins, bool x_wins);
+        // next_move on a thread of its own. Nothing else may be called until the future is ready, except stop_search,
+        // which may come from any thread and makes the search return the best move of its deepest finished iteration
+        future<SearchResult> start_search(bool player, uint32_t o_board, uint32_t x_board, uint32_t kings, bool o_wins, bool x_wins,
+                                          ProgressCallback progress = nullptr);
+        void stop_search() { cancelled = true; }
+        void set_hash_size(size_t size_mb);
+        void set_limits(SearchLimits limits);
+        void set_algorithm(SearchAlgorithm algorithm);
+        void set_selectivity(const Selectivity& selectivity);
+        // how many of the best root moves the search gives exact scores for, best first in last_lines
+        void set_multi_pv(int count);
+        const Selectivity& get_selectivity() { return this->selectivity; }
+        void set_threads(int threads);
+        bool load_endgame_db(const string& path);
+        bool load_opening_book(const string& path);
+        void share_databases(const PlayerAI& other);
+        void set_weights(const EvalWeights& weights);
+        bool load_weights(const string& path);
 
         uint32_t o_board() { return this->board[1]; }
         uint32_t x_board() { return this->board[0]; }
         uint32_t kings() { return this->board[2]; }
 
-    private:
-        static const uint32_t EVEN_MASK = 252645135;
-        static const uint32_t ROW_END_MASK = 4026531855;
-        static const uint32_t O_BACK_RANK = 15;
-        static const uint32_t X_BACK_RANK = 4026531840;
-        static const uint32_t L_COL_MASK = 16843009;
-        static const uint32_t R_COL_MASK = 2155905152;
+        // move played by the last search and its score, positive favours x
+        uint32_t last_move() { return this->root_move; }
+        float last_score() { return this->root_score; }
+        const SearchStats& last_stats() { return this->stats; }
+        // best first, at most the multi-pv count and fewer when there are fewer root moves
+        int last_line_count() { return this->line_count; }
+        const RootLine& last_line(int rank) { return this->lines[rank]; }
 
+    private:
         uint32_t board[3];
         bool o_wins = false, x_wins = false;
 
-        ScoreMovePair minimax(uint32_t board[], int depth, bool max_player);
-        ScoreMovePair alphabeta(uint32_t board[], int depth, bool max_player, float alpha, float beta);
+        MoveList ply_moves[MAX_PLY];
+        UndoRecord undo_stack[MAX_PLY];
+        uint32_t search_board[3];
+        uint64_t search_hash = 0;
+        int search_eval = 0;
+        shared_ptr<TranspositionTable> table;
+        shared_ptr<EndgameDB> endgame_db;
+        shared_ptr<OpeningBook> opening_book;
+        Evaluation evaluator;
+
+        SearchLimits limits;
+        SearchAlgorithm algorithm = SEARCH_PVS;
+        Selectivity selectivity = {};
+        // both hold multi_pv lines with room for a MAX_PLY long pv, so a search fills them without allocating.
+        // found_lines collects an iteration's lines and is swapped with lines once the iteration finishes
+        int multi_pv = 1;
+        vector<RootLine> lines, found_lines;
+        int line_count = 0;
+        chrono::steady_clock::time_point start_time;
+        uint64_t nodes = 0;
+        uint32_t root_move = 0;
+        float root_score = 0;
+        SearchStats stats;
+        uint32_t killers[MAX_PLY][2];
+        int history[2][32][32];
+        atomic<bool> stopped { false };
+        bool can_stop = false;
+        int root_depth = 0;
+
+        // the search started by start_search. cancelled is only cleared when a search starts, so a stop_search that
+        // comes before the search thread gets going is not lost
+        thread search_thread;
+        atomic<bool> cancelled { false };
+        // a pondering search that the new search takes over reports through it too
+        mutex progress_lock;
+        ProgressCallback progress;
+
+        // the search of the position after the expected reply runs here while the opponent thinks
+        thread ponder_thread;
+        atomic<bool> pondering { false };
+        uint32_t ponder_board[3];
+        bool ponder_player = false;
+
+        // lazy smp: every helper is a complete searcher of its own sharing only the table
+        vector<unique_ptr<PlayerAI>> helpers;
+        vector<thread> helper_threads;
+
+        PlayerAI(shared_ptr<TranspositionTable> table);
+
+        // the searches next_move runs for the algorithm that is set, both play the move they find on the board
+        void minimax(int depth, bool max_player);
+        void iterative_deepening(bool max_player);
+
+        void new_search();
+        void search(bool max_player);
+        ScoreMovePair aspiration_search(int depth, bool max_player);
+        ScoreMovePair multi_pv_search(int depth, bool max_player);
+        ScoreMovePair root_search(int depth, bool max_player, float alpha, float beta, int excluded);
+        void principal_variation(vector<uint32_t>& pv, uint32_t move, bool max_player, int depth);
+        void reserve_lines();
+        void set_single_line(uint32_t move, float score);
+        bool ponder_hit(bool max_player, uint32_t o_board, uint32_t x_board, uint32_t kings);
+        void find_move(bool player, uint32_t o_board, uint32_t x_board, uint32_t kings, bool o_wins, bool x_wins);
+        void join_search();
+        void set_progress(ProgressCallback progress);
+
+        void start_helpers(bool max_player);
+        void stop_helpers();
+        void helper_search(bool max_player, int id);
+
+        bool limits_reached();
+        bool probe_opening_book(bool max_player);
+        bool probe_endgame_db(uint32_t board[], bool max_player, float& score);
+        uint64_t perft(uint32_t board[], int depth, int ply, bool is_o);
+        void clear_ordering();
+        void order_moves(uint32_t board[], bool is_o, int ply, uint32_t hash_move, MoveList& moves);
+        void update_ordering(uint32_t board[], bool is_o, int ply, int depth, uint32_t move);
+
+        ScoreMovePair minimax(uint32_t board[], int depth, int ply, bool max_player);
+        ScoreMovePair alphabeta(uint32_t board[], int depth, int ply, bool max_player, float alpha, float beta);
+        float quiescence(uint32_t board[], int ply, bool max_player, float alpha, float beta);
 
         void update(uint32_t o_board, uint32_t x_board, uint32_t kings, bool o_wins, bool x_wins);
         float evaluate(uint32_t board[]);
+        float evaluate(uint32_t board[], int eval);
 
-        unordered_map<uint32_t, uint32_t> get_piece_moves(uint32_t board[], uint32_t pos);
-        unordered_map<uint32_t, uint32_t> get_piece_moves(uint32_t board[], uint32_t pos, uint32_t origin, uint32_t captures);
+        void get_piece_moves(uint32_t board[], uint32_t pos, MoveList& moves);
+        void get_piece_captures(uint32_t board[], uint32_t pos, MoveList& moves);
+        void get_piece_moves(uint32_t board[], uint32_t origin, bool quiet, MoveList& moves, int first);
         void simulate_move(uint32_t board[], uint32_t new_board[], uint32_t move, bool is_o, bool promote);
-        vector<uint32_t> get_all_moves(uint32_t board[], bool is_o);
+        void set_search_board(bool max_player);
+        void make_move(uint32_t board[], uint32_t move, bool is_o, UndoRecord& undo);
+        void unmake_move(uint32_t board[], uint32_t move, bool is_o, const UndoRecord& undo);
+        void get_all_captures(uint32_t board[], bool is_o, MoveList& moves);
+        void get_all_moves(uint32_t board[], bool is_o, MoveList& moves);
+        bool is_quiet(uint32_t board[], uint32_t move, bool is_o);
 
         uint32_t move(uint32_t pos, bool left, bool forward, bool o_turn);
         int bitsize(uint32_t num);
@@ -0,0 +1,42 @@
+#ifndef SEARCHSTATS_H
+#define SEARCHSTATS_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+struct IterationStats {
+    int depth;
+    uint64_t nodes;
+    double time_ms;
+    float score;
+    uint32_t move;
+};
+
+// counters of one search by the main thread, only filled in when SEARCH_STATS is enabled in PlayerAI.cpp
+struct SearchStats {
+    uint64_t nodes = 0;
+    uint64_t quiescence_nodes = 0;
+    uint64_t evaluations = 0;
+    uint64_t beta_cutoffs = 0;
+    uint64_t first_move_cutoffs = 0;
+    uint64_t tt_probes = 0;
+    uint64_t tt_hits = 0;
+    uint64_t tt_cutoffs = 0;
+    uint64_t reductions = 0;
+    uint64_t re_searches = 0;
+    uint64_t futility_prunes = 0;
+    double time_ms = 0;
+    vector<IterationStats> iterations;
+
+    void clear();
+    double nps() const;
+    double first_move_cutoff_rate() const;
+
+    // the whole search on one line of json, so a run can be logged as json lines
+    string to_json() const;
+};
+
+#endif // SEARCHSTATS_H
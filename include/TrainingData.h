@@ -0,0 +1,93 @@
+#ifndef TRAININGDATA_H
+#define TRAININGDATA_H
+
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+#include "MappedFile.h"
+
+using namespace std;
+
+// A training file is a header followed by fixed size records of searched positions in the order they were written,
+// so a reader maps the file and uses the records in place
+
+// board is {uint32_t x_board, uint32_t o_board, uint32_t kings}, score and result favour x like the search does
+struct TrainingRecord {
+    uint32_t board[3];
+    uint8_t is_o;
+    // 1 when x won the game, -1 when o won, 0 for a draw
+    int8_t result;
+    uint16_t reserved;
+    float score;
+    uint32_t move;
+};
+
+// writes whole games once their result is known, positions that are already in the file are skipped. A failed write
+// is remembered, nothing more is written after it and close reports it
+class TrainingWriter
+{
+    public:
+        TrainingWriter();
+        virtual ~TrainingWriter();
+
+        TrainingWriter(const TrainingWriter&) = delete;
+        TrainingWriter& operator=(const TrainingWriter&) = delete;
+
+        bool open(const string& path);
+        // false if any write failed, the header then counts only the records before the failure
+        bool close();
+
+        bool is_open() const { return file != nullptr; }
+        bool failed() const { return error; }
+        void write_game(vector<TrainingRecord>& positions, int result);
+
+        // records that have reached the file
+        uint64_t written() const { return count; }
+        uint64_t duplicates() const { return skipped; }
+
+    private:
+        FILE* file = nullptr;
+        vector<TrainingRecord> buffer;
+        uint64_t count = 0;
+        uint64_t skipped = 0;
+        bool error = false;
+
+        // open addressing set of the hashes written so far, 0 marks an empty slot
+        vector<uint64_t> seen;
+        uint64_t seen_count = 0;
+
+        bool insert(uint64_t key);
+        bool flush();
+};
+
+class TrainingData
+{
+    public:
+        struct Header {
+            char magic[8];
+            uint64_t count;
+        };
+
+        static const char MAGIC[8];
+
+        TrainingData();
+        virtual ~TrainingData();
+
+        bool open(const string& path);
+        void close();
+
+        bool is_open() const { return file.is_open(); }
+        uint64_t size() const { return count; }
+
+        const TrainingRecord& operator[](uint64_t i) const { return records[i]; }
+        const TrainingRecord* begin() const { return records; }
+        const TrainingRecord* end() const { return records + count; }
+
+    private:
+        MappedFile file;
+        const TrainingRecord* records = nullptr;
+        uint64_t count = 0;
+};
+
+#endif // TRAININGDATA_H
@@ -0,0 +1,59 @@
+#ifndef TRANSPOSITIONTABLE_H
+#define TRANSPOSITIONTABLE_H
+
+#include <cstdint>
+#include <cstddef>
+#include <atomic>
+#include <memory>
+
+using namespace std;
+
+enum Bound : uint8_t { BOUND_NONE, BOUND_UPPER, BOUND_LOWER, BOUND_EXACT };
+
+struct TTEntry {
+    uint32_t move;
+    float score;
+    int depth;
+    Bound bound;
+};
+
+// board is {uint32_t x_board, uint32_t o_board, uint32_t kings}
+
+class TranspositionTable
+{
+    public:
+        TranspositionTable(size_t size_mb);
+        virtual ~TranspositionTable();
+
+        void resize(size_t size_mb);
+        void clear();
+        void new_search();
+
+        bool probe(uint64_t key, TTEntry& entry);
+        void store(uint64_t key, uint32_t move, float score, int depth, Bound bound);
+
+        static uint64_t hash(const uint32_t board[], bool is_o);
+
+        // piece is 0 to 3 for x men, o men, x kings and o kings
+        static uint64_t piece_key(int piece, int square);
+        static uint64_t side_key();
+
+    private:
+        // an entry is packed into two words: the upper 48 bits of the key with depth, bound and
+        // generation, then the move with the score bits. The first word is stored xored with the
+        // second, so an entry torn by two threads writing at once fails the key check instead of
+        // returning a mix of both, which lets search threads share the table without locks
+        struct Cluster {
+            atomic<uint64_t> data[4][2];
+        };
+
+        static const int CLUSTER_SIZE = 4;
+        static const uint64_t KEY_MASK = 0xFFFFFFFFFFFF0000;
+
+        unique_ptr<Cluster[]> clusters;
+        size_t cluster_count = 0;
+        // engines of different games that share the table each advance it when they start a search
+        atomic<uint8_t> generation { 0 };
+};
+
+#endif // TRANSPOSITIONTABLE_H
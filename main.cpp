@@ -1,267 +1,485 @@
 #include <iostream>
 #include <sstream>
-#include "PlayerAI.h"
-
-#define O_PIECE 'O'
-#define X_PIECE 'X'
-#define O_KING '@'
-#define X_KING '#'
-#define SPACE '*'
+#include <string>
+#include <vector>
+#include <chrono>
+#include <random>
+#include <thread>
+#include <mutex>
+#include <atomic>
+#include <algorithm>
+#include "Game.h"
+#include "GameServer.h"
+#include "TrainingData.h"
+
+// self-play games still going after this many plies are drawn
+#define SELFPLAY_MAX_PLIES 300
 
 using namespace std;
 
-const uint32_t EVEN_MASK = 252645135;
-const uint32_t ROW_END_MASK = 4026531855;
-const uint32_t O_BACK_RANK = 15;
-const uint32_t X_BACK_RANK = 4026531840;
-const uint32_t L_COL_MASK = 16843009;
-const uint32_t R_COL_MASK = 2155905152;
 
-uint32_t x_board = 4293918720;
-uint32_t o_board = 4095;
-uint32_t kings = 0;
+// perft <depth> [x_board o_board kings o|x], starts from the opening position by default
+int run_perft(int argc, char* argv[])
+{
+    int depth = (argc > 2) ? stoi(argv[2]) : 6;
+    uint32_t x_board = 4293918720, o_board = 4095, kings = 0;
+    bool o_turn = true;
+    if (argc > 6)
+    {
+        x_board = stoul(argv[3]);
+        o_board = stoul(argv[4]);
+        kings = stoul(argv[5]);
+        o_turn = string(argv[6]) != "x";
+    }
 
-bool o_turn = true;
-bool o_wins = false, x_wins = false;
-uint32_t piece_pos;
+    vector<pair<uint32_t, uint64_t>> divide;
 
-PlayerAI playerAI(o_board, x_board, kings);
+    unique_ptr<PlayerAI> playerAI(new PlayerAI(o_board, x_board, kings));
+    auto start = chrono::steady_clock::now();
+    uint64_t nodes = playerAI->perft(o_board, x_board, kings, o_turn, depth, &divide);
+    double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
 
-bool is_space(uint32_t pos)
-{
-    return pos & ~(o_board + x_board);
-}
+    uint32_t player = o_turn ? o_board : x_board, opponent = o_turn ? x_board : o_board;
+    for (const auto& root_move : divide)
+        cout << Game::move_name(root_move.first, player, opponent) << ": " << root_move.second << endl;
 
-char getKingSide(char king)
-{
-    if (king == O_KING)
-        return O_PIECE;
-    else if (king == X_KING)
-        return X_PIECE;
-    else
-        return king;
+    cout << "\nPlayer: " << (o_turn ? O_PIECE : X_PIECE) << "\nDepth: " << depth << "\nNodes: " << nodes << endl;
+    cout << "Time: " << seconds * 1000 << " ms\n";
+    cout << "Nodes/second: " << (uint64_t)(nodes / max(seconds, 1e-9)) << endl;
 
+    return 0;
 }
 
-bool same_side(uint32_t pos, char piece)
+// how one side of a self-play match searches, a plain number is a depth and "<n>ms" a time per move
+SearchLimits parse_limits(const string& arg)
 {
-    piece = getKingSide(piece);
-    return
-        piece == O_PIECE && (o_board & pos) ||
-        piece == X_PIECE && (x_board & pos);
+    if (arg.size() > 2 && arg.substr(arg.size() - 2) == "ms")
+        return { 0, stoi(arg), 0 };
+
+    return { stoi(arg), 0, 0 };
 }
 
-void add_piece(bool is_o, uint32_t pos, bool is_king)
+struct GameResult {
+    char winner;
+    int plies;
+    double ms[2];
+    int searched[2];
+    string moves;
+    // every searched position, for training data
+    vector<TrainingRecord> positions;
+};
+
+// plays one game from the opening position, engines[0] plays O and moves first, a draw is reported as SPACE
+GameResult play_game(PlayerAI* engines[2], mt19937& rng, int random_plies)
 {
-    if (is_o)
-        o_board |= pos;
-    else
-        x_board |= pos;
+    uint32_t board[3] = { 4293918720, 4095, 0 };
+    bool is_o = true;
+    GameResult result = { SPACE, 0, { 0, 0 }, { 0, 0 }, "" };
+    ostringstream moves_log;
 
-    if (is_king)
-        kings |= pos;
-}
+    // positions since the last capture or man move, the third time one comes up is a draw
+    vector<uint64_t> seen;
 
-void remove_piece(bool is_o, uint32_t pos)
-{
-    if (is_o)
-        o_board &= ~pos;
-    else
-        x_board &= ~pos;
+    for (; result.plies < SELFPLAY_MAX_PLIES; result.plies++)
+    {
+        PlayerAI* engine = engines[!is_o];
+        MoveList moves;
+        engine->generate_moves(board, is_o, moves);
+        if (moves.empty())
+        {
+            result.winner = is_o ? X_PIECE : O_PIECE;
+            break;
+        }
+
+        uint64_t hash = TranspositionTable::hash(board, is_o);
+        if (count(seen.begin(), seen.end(), hash) >= 2)
+            break;
+        seen.push_back(hash);
 
-    kings &= ~pos;
+        uint32_t player = board[is_o], opponent = board[!is_o], men = player & ~board[2];
+        uint32_t move;
+        double ms = 0;
+        if (result.plies < random_plies)
+        {
+            // a few random moves first, otherwise every game at a fixed depth would be the same
+            move = moves[uniform_int_distribution<int>(0, moves.size() - 1)(rng)];
+            engine->apply_move(board, board, move, is_o);
+        }
+        else
+        {
+            TrainingRecord record = { { board[0], board[1], board[2] }, is_o, 0, 0, 0, 0 };
+
+            auto start = chrono::steady_clock::now();
+            engine->next_move(!is_o, board[1], board[0], board[2], false, false);
+            ms = chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+
+            move = engine->last_move();
+            record.score = engine->last_score();
+            record.move = move;
+            result.positions.push_back(record);
+            result.searched[!is_o]++;
+            board[0] = engine->x_board();
+            board[1] = engine->o_board();
+            board[2] = engine->kings();
+        }
+
+        if ((move & opponent) || (move & men))
+            seen.clear();
+
+        result.ms[!is_o] += ms;
+        moves_log << " " << Game::move_name(move, player, opponent) << "/" << (int)ms;
+        is_o = !is_o;
+    }
+
+    result.moves = moves_log.str();
+    return result;
 }
 
-// return 0 if move is out of bounds
-uint32_t move(uint32_t pos, bool left, bool forward, bool o_turn)
+// selfplay [games] [threads] [engine a] [engine b] [random plies] [training file], engines are a depth or a time such as 100ms
+int run_selfplay(int argc, char* argv[])
 {
-    bool shift_left = o_turn == forward;
-    int shift_value = 5;
+    const int games = (argc > 2) ? stoi(argv[2]) : 100;
+    const int threads = (argc > 3) ? stoi(argv[3]) : max(1u, thread::hardware_concurrency());
+    const SearchLimits limits[2] = { parse_limits((argc > 4) ? argv[4] : "8"), parse_limits((argc > 5) ? argv[5] : "8") };
+    const int random_plies = (argc > 6) ? stoi(argv[6]) : 4;
 
-    if (pos & EVEN_MASK)
-        shift_value--;
-    if (left)
-        shift_value--;
-    if (!shift_left)
-        shift_value = 8 - shift_value;
+    TrainingWriter training;
+    if (argc > 7 && !training.open(argv[7]))
+    {
+        cerr << "cannot write " << argv[7] << endl;
+        return 1;
+    }
 
-    if ((left && (pos & L_COL_MASK)) || (!left && (pos & R_COL_MASK)))
-        return 0;
+    // wins for a and b, draws, and the time each engine spent over its moves
+    atomic<int> next_game { 0 };
+    int score[3] = { 0, 0, 0 };
+    double total_ms[2] = { 0, 0 };
+    int total_moves[2] = { 0, 0 };
+    mutex output_mutex;
 
-    if (shift_left)
-        pos <<= shift_value;
-    else
-        pos >>= shift_value;
+    auto start = chrono::steady_clock::now();
+    auto worker = [&]()
+    {
+        unique_ptr<PlayerAI> engine_a(new PlayerAI(0, 0, 0)), engine_b(new PlayerAI(0, 0, 0));
+        engine_a->set_threads(1);
+        engine_b->set_threads(1);
+        engine_a->set_limits(limits[0]);
+        engine_b->set_limits(limits[1]);
 
-    return pos;
-}
+        for (int game = next_game++; game < games; game = next_game++)
+        {
+            // games come in pairs with the same random opening and the colours swapped
+            mt19937 rng(game / 2);
+            bool a_is_o = game % 2 == 0;
+            PlayerAI* engines[2] = { a_is_o ? engine_a.get() : engine_b.get(), a_is_o ? engine_b.get() : engine_a.get() };
+
+            GameResult result = play_game(engines, rng, random_plies);
+
+            int a_index = !a_is_o;
+            int winner = (result.winner == SPACE) ? 2 : (result.winner == (a_is_o ? O_PIECE : X_PIECE)) ? 0 : 1;
+            lock_guard<mutex> lock(output_mutex);
+            score[winner]++;
+            total_ms[0] += result.ms[a_index];
+            total_ms[1] += result.ms[!a_index];
+            total_moves[0] += result.searched[a_index];
+            total_moves[1] += result.searched[!a_index];
+
+            if (training.is_open())
+                training.write_game(result.positions, (result.winner == X_PIECE) ? 1 : (result.winner == O_PIECE) ? -1 : 0);
+
+            cout << game << " " << (a_is_o ? "ab" : "ba") << " " << result.winner << " " << result.plies << result.moves << endl;
+        }
+    };
 
-uint32_t move(uint32_t pos, bool left, bool forward)
-{
-    return move(pos, left, forward, same_side(pos, O_PIECE));
-}
+    vector<thread> workers;
+    for (int i = 0; i < threads; i++)
+        workers.emplace_back(worker);
+    for (thread& t : workers)
+        t.join();
 
-char getPiece(uint32_t pos)
-{
-    char piece = (pos & o_board) ? O_KING : ((pos & x_board) ? X_KING : SPACE);
-    return (pos & kings) ? piece : getKingSide(piece);
+    double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+    cout << "\nGames: " << games << "\nA wins: " << score[0] << "\nB wins: " << score[1] << "\nDraws: " << score[2] << endl;
+    cout << "A ms/move: " << total_ms[0] / max(total_moves[0], 1) << "\nB ms/move: " << total_ms[1] / max(total_moves[1], 1) << endl;
+    cout << "Time: " << seconds << " s\nGames/second: " << games / max(seconds, 1e-9) << endl;
+
+    if (training.is_open())
+    {
+        bool written = training.close();
+        cout << "Positions written: " << training.written() << "\nDuplicates skipped: " << training.duplicates() << endl;
+        if (!written)
+        {
+            cerr << "writing " << argv[7] << " failed, the file holds only the positions written before that" << endl;
+            return 1;
+        }
+    }
+
+    return 0;
 }
 
-// left and forward always first [lf, rf, lb, rb]
-void available_captures(bool* captures, uint32_t pos)
+// reads "x_board o_board kings o|x" or a fen such as "B:W21,22,K30:B1,2,K9", where B is O and square n is bit n - 1,
+// anything after the position is returned in rest. Either way a side has at most 12 pieces, no square holds both
+// sides and every king is on an occupied square, which is what the move generation relies on
+bool parse_position(const string& line, uint32_t board[], bool& is_o, string& rest)
 {
-    bool is_o = same_side(pos, O_PIECE);
-    uint32_t opponent = is_o ? x_board : o_board;
-
-    captures[0] = false;
-    const int direction_count = (pos & kings) ? 4 : 2;
-    bool left = true, forward = true;
-    uint32_t capture_pos, new_pos;
-    for (int i = 0; i < direction_count; i++)
+    istringstream in(line);
+    string first;
+    in >> first;
+
+    board[0] = board[1] = board[2] = 0;
+    if (first.find(':') == string::npos)
+    {
+        // read wider than 32 bits, so values that don't fit or are negative are rejected instead of wrapped
+        istringstream values(first);
+        long long value[3];
+        string side;
+        if (!(values >> value[0]) || !values.eof() || !(in >> value[1] >> value[2] >> side) || (side != "o" && side != "x"))
+            return false;
+
+        for (int i = 0; i < 3; i++)
+        {
+            if (value[i] < 0 || value[i] > UINT32_MAX)
+                return false;
+            board[i] = (uint32_t)value[i];
+        }
+        is_o = side == "o";
+    }
+    else
     {
-        captures[i + 1] = false;
-        capture_pos = move(pos, left, forward);
-        if (capture_pos && (opponent & capture_pos))
+        if (first[0] != 'B' && first[0] != 'W')
+            return false;
+        is_o = first[0] == 'B';
+
+        istringstream fields(first.substr(2));
+        string field;
+        while (getline(fields, field, ':'))
         {
-            new_pos = move(capture_pos, left, forward, is_o);
-            if (new_pos && is_space(new_pos))
+            if (field.empty() || (field[0] != 'B' && field[0] != 'W'))
+                return false;
+            uint32_t& pieces = board[field[0] == 'B'];
+
+            istringstream squares(field.substr(1));
+            string square;
+            while (getline(squares, square, ','))
             {
-                captures[i + 1] = true;
-                captures[0] = true;
+                bool king = !square.empty() && square[0] == 'K';
+                int n = stoi(square.substr(king));
+                if (n < 1 || n > 32)
+                    return false;
+
+                pieces |= 1u << (n - 1);
+                if (king)
+                    board[2] |= 1u << (n - 1);
             }
-
         }
-
-        left = !left;
-        if (left)
-            forward = !forward;
     }
+
+    if ((board[0] & board[1]) || (board[2] & ~(board[0] | board[1])) ||
+        __builtin_popcount(board[0]) > 12 || __builtin_popcount(board[1]) > 12)
+        return false;
+
+    getline(in >> ws, rest);
+    return true;
 }
 
-bool has_move(uint32_t pos)
+// the scored root moves of the last search with their expected lines, as a json array
+string lines_json(PlayerAI& playerAI, const uint32_t board[], bool is_o)
 {
-    bool o_turn = same_side(pos, O_PIECE);
-    uint32_t opponent = o_turn ? x_board : o_board;
+    ostringstream json;
+    json << "[";
 
-    const char direction_count = (pos & kings) ? 4 : 2;
-    bool left = true, forward = true;
-    uint32_t new_pos;
-    for (char i = 0; i < direction_count; i++)
+    for (int i = 0; i < playerAI.last_line_count(); i++)
     {
-        new_pos = move(pos, left, forward);
-        if (is_space(new_pos))
-            return true;
-        else if (new_pos & opponent)
-        {
-            new_pos = move(new_pos, left, forward, o_turn);
-            if (is_space(new_pos))
-                return true;
+        const RootLine& line = playerAI.last_line(i);
+        json << (i ? "," : "") << "{\"score\":" << line.score << ",\"pv\":[";
 
+        uint32_t line_board[3] = { board[0], board[1], board[2] };
+        bool line_o = is_o;
+        for (size_t ply = 0; ply < line.pv.size(); ply++)
+        {
+            uint32_t move = line.pv[ply];
+            json << (ply ? "," : "") << "\"" << Game::move_name(move, line_board[line_o], line_board[!line_o]) << "\"";
+            playerAI.apply_move(line_board, line_board, move, line_o);
+            line_o = !line_o;
         }
 
-        left = !left;
-        if (left)
-            forward = !forward;
+        json << "]}";
     }
 
-    return false;
+    json << "]";
+    return json.str();
 }
 
-bool is_winner(bool o_turn)
+// engine [engine] [threads], answers one position per line on stdin until "quit" or the end of input, keeping the
+// table between positions. A position can end with its own depth or time, "limit <engine>" changes the default
+// and "multipv <count>" how many of the best moves are scored. A position is searched in the background with an
+// info line after every depth, "stop" ends the search early and any other line waits for it
+int run_engine(int argc, char* argv[])
 {
-    uint32_t opponent = o_turn ? x_board : o_board;
-    for (uint32_t pos = 1; pos != 0; pos <<= 1)
-        if ((pos & opponent) && has_move(pos))
-            return false;
+    SearchLimits default_limits = parse_limits((argc > 2) ? argv[2] : "8");
+    unique_ptr<PlayerAI> playerAI(new PlayerAI(0, 0, 0));
+    if (argc > 3)
+        playerAI->set_threads(stoi(argv[3]));
+
+    playerAI->load_endgame_db("endgame.db");
+    playerAI->load_opening_book("opening.book");
+    playerAI->load_weights("eval.weights");
+
+    // prints the reply once the search is done, only one search runs at a time
+    thread reply;
+    auto wait_reply = [&reply]()
+    {
+        if (reply.joinable())
+            reply.join();
+    };
 
-    return true;
-}
+    string line;
+    while (getline(cin, line))
+    {
+        if (line.empty())
+            continue;
+        if (line == "stop")
+        {
+            playerAI->stop_search();
+            continue;
+        }
+        if (line == "quit")
+        {
+            playerAI->stop_search();
+            break;
+        }
 
-void change_turn()
-{
-    uint32_t king_rank = o_turn ? X_BACK_RANK : O_BACK_RANK;
-    uint32_t player_board = o_turn ? o_board : x_board;
-    kings |= player_board & king_rank;
+        wait_reply();
+        try
+        {
+            if (line.compare(0, 8, "multipv ") == 0)
+            {
+                playerAI->set_multi_pv(stoi(line.substr(8)));
+                cout << "ok" << endl;
+                continue;
+            }
 
-    if (o_turn)
-        o_wins = is_winner(o_turn);
-    else
-        x_wins = is_winner(o_turn);
+            if (line.compare(0, 6, "limit ") == 0)
+            {
+                default_limits = parse_limits(line.substr(6));
+                cout << "ok" << endl;
+                continue;
+            }
+
+            uint32_t board[3];
+            bool is_o;
+            string rest;
+            if (!parse_position(line, board, is_o, rest))
+            {
+                cout << "error bad position: " << line << endl;
+                continue;
+            }
+
+            MoveList moves;
+            playerAI->generate_moves(board, is_o, moves);
+            if (moves.empty())
+            {
+                cout << "bestmove none" << endl;
+                continue;
+            }
 
-    o_turn = !o_turn;
+            playerAI->set_limits(rest.empty() ? default_limits : parse_limits(rest));
+            future<SearchResult> result = playerAI->start_search(!is_o, board[1], board[0], board[2], false, false,
+                [=](const IterationStats& iteration)
+                {
+                    cout << "info depth " << iteration.depth << " score " << iteration.score
+                         << " move " << Game::move_name(iteration.move, board[is_o], board[!is_o])
+                         << " nodes " << iteration.nodes << " time_ms " << iteration.time_ms << endl;
+                });
+
+            reply = thread([=, &playerAI, result = std::move(result)]() mutable
+            {
+                uint32_t move = result.get().move;
+                cout << "bestmove " << Game::move_name(move, board[is_o], board[!is_o]) << " " << move
+                     << " score " << playerAI->last_score()
+                     << " board " << playerAI->x_board() << " " << playerAI->o_board() << " " << playerAI->kings() << " " << (is_o ? "x" : "o")
+                     << " lines " << lines_json(*playerAI, board, is_o)
+                     << " stats " << playerAI->last_stats().to_json() << endl;
+            });
+        }
+        catch (const exception&)
+        {
+            cout << "error bad input: " << line << endl;
+        }
+    }
+
+    wait_reply();
+    return 0;
 }
 
-char getTurnChar()
+
+// server [socket] [threads] [engine] [shared table mb] [session table mb], hosts one game per connection until
+// killed, a shared table size of 0 gives every game a table of its own of the session size
+int run_server(int argc, char* argv[])
 {
-    return o_turn ? O_PIECE : X_PIECE;
+    const string path = (argc > 2) ? argv[2] : "checkers.sock";
+    const int threads = (argc > 3) ? stoi(argv[3]) : max(1u, thread::hardware_concurrency());
+    const SearchLimits limits = parse_limits((argc > 4) ? argv[4] : "8");
+    const size_t table_mb = (argc > 5) ? stoul(argv[5]) : 256;
+
+    GameServer server(path, threads, limits, table_mb);
+    if (argc > 6)
+        server.set_session_table_size(stoul(argv[6]));
+    server.load_endgame_db("endgame.db");
+    server.load_opening_book("opening.book");
+    server.load_weights("eval.weights");
+
+    if (!server.run())
+    {
+        cerr << "cannot listen on " << path << endl;
+        return 1;
+    }
+
+    return 0;
 }
 
-int main()
+int main(int argc, char* argv[])
 {
-    string message = "";
-    bool next_capture[] = { false, false, false, false, false };
+    if (argc > 1 && string(argv[1]) == "perft")
+        return run_perft(argc, argv);
+    if (argc > 1 && string(argv[1]) == "selfplay")
+        return run_selfplay(argc, argv);
+    if (argc > 1 && string(argv[1]) == "engine")
+        return run_engine(argc, argv);
+    if (argc > 1 && string(argv[1]) == "server")
+        return run_server(argc, argv);
+
+    Game game;
+
+    // optional, built by the EndgameGen target
+    game.engine().load_endgame_db("endgame.db");
+    // optional, built by the BookGen target
+    game.engine().load_opening_book("opening.book");
+    // optional, built by the Tuner target
+    game.engine().load_weights("eval.weights");
 
-    ostringstream str_stream;
+    string message = "";
 
     while (true)
     {
         //system("pause");
         system("@cls||clear");
-        if (o_wins)
-            cout << "Winner: O\n";
-        else if (x_wins)
-            cout << "Winner: X\n";
+        if (game.winner() != SPACE)
+            cout << "Winner: " << game.winner() << endl;
         else
-            cout << "Player: " << getTurnChar() << endl;
-
-        str_stream << "\n     1   2   3   4   5   6   7   8\n";
-        str_stream << "    --------------------------------\n";
-
-        bool even = false;
-        int row_num = 1;
-        int col_cycle = 0;
-        char piece;
-        for (uint32_t pos = 1 << 28; pos; pos >>= 4)
-        {
-            str_stream << " " << row_num << " ";
-            if (!even)
-                str_stream << "| ";
-
-            for (col_cycle = 0; col_cycle < 4; col_cycle++)
-            {
-                piece = getPiece(pos << col_cycle);
-                if (even)
-                    str_stream << "| " << piece << " | " << SPACE << " ";
-                else
-                    str_stream << SPACE << " | " << piece << " | ";
-            }
+            cout << "Player: " << game.turn_char() << endl;
 
-            if (even)
-                str_stream << "|";
+        cout << game.board_string();
 
-            str_stream << "\n    --------------------------------\n";
-            even = !even;
-            row_num++;
-        }
-
-        cout << str_stream.str();
-        str_stream.str(string());
-        str_stream.clear();
-
-        if (o_wins || x_wins)
+        if (game.winner() != SPACE)
         {
-            cout << "\nPlayer " << (o_wins ? O_PIECE : X_PIECE) << " has won the game!\n\n";
+            cout << "\nPlayer " << game.winner() << " has won the game!\n\n";
             break;
         }
 
-        if (!o_turn)
+        if (!game.is_o_turn())
         {
-            playerAI.next_move(!o_turn, o_board, x_board, kings, o_wins, x_wins);
-            o_board = playerAI.o_board();
-            x_board = playerAI.x_board();
-            kings = playerAI.kings();
-
-            change_turn();
+            // keeps searching on the move it expects while the player types
+            game.engine_move(true);
             continue;
         }
 
@@ -272,8 +490,9 @@ int main()
             message = "";
         }
 
-        if (next_capture[0])
+        if (game.capturing())
         {
+            const bool* next_capture = game.capture_options();
             cout << "N to finish";
             if (next_capture[1] || next_capture[3])
                 cout << ", L for left";
@@ -285,11 +504,10 @@ int main()
 
             if (direction == "n")
             {
-                o_turn = !o_turn;
-                next_capture[0] = false;
+                game.finish_capture();
             }
-            else if (direction == "l" && (next_capture[1] || next_capture[3]) ||
-                     direction == "r" && (next_capture[2] || next_capture[4]))
+            else if ((direction == "l" && (next_capture[1] || next_capture[3])) ||
+                     (direction == "r" && (next_capture[2] || next_capture[4])))
             {
                 char dir_index = (direction == "l") ? 1 : 2;
                 bool forward = next_capture[dir_index];
@@ -308,20 +526,9 @@ int main()
                     forward = forward_string == "f";
                 }
 
-                uint32_t capture_pos = move(piece_pos, direction == "l", forward);
-                uint32_t new_pos = move(capture_pos, direction == "l", forward, o_turn);
-
-                add_piece(o_turn, new_pos, piece_pos & kings);
-                remove_piece(!o_turn, capture_pos);
-                remove_piece(o_turn, piece_pos);
-
-                piece_pos = new_pos;
-                available_captures(next_capture, piece_pos);
-
-                if (next_capture[0])
+                message = game.continue_capture(direction == "l", forward);
+                if (message.empty() && game.capturing())
                     message = "You can continue capturing";
-                else
-                    change_turn();
             }
             else
             {
@@ -344,42 +551,18 @@ int main()
         cout << "L for left, R for right: ";
         cin >> direction;
 
-        if (piece_x < 1 || piece_x > 8 || piece_y < 1 || piece_y > 8)
-        {
-            message = "Expected valid column and row numbers";
-            continue;
-        }
-
         if (direction != "l" && direction != "r")
         {
             message = "Movement should be L (left) or R (right)";
             continue;
         }
 
-        piece_x = piece_x - 1 - (piece_y % 2);
-        if (piece_x % 2 == 1)
-        {
-            message = "Empty square chosen";
-            continue;
-        }
-
-        piece_x = piece_x / 2;
-        piece_y = 8 - piece_y;
-        piece_pos = 1 << (piece_y * 4 + piece_x);
-
-        if (is_space(piece_pos))
-        {
-            message = "Empty square chosen";
-            continue;
-        }
-        if (!same_side(piece_pos, getTurnChar()))
-        {
-            message = "Enemy piece chosen";
+        message = game.select_piece(piece_y, piece_x);
+        if (!message.empty())
             continue;
-        }
 
         bool forward = true;
-        if (piece_pos & kings)
+        if (game.selected_king())
         {
             cout << "F for forwards, B for backwards: ";
             string forward_input;
@@ -394,55 +577,8 @@ int main()
             forward = forward_input == "f";
         }
 
-        uint32_t new_pos = move(piece_pos, direction == "l", forward);
-        if (!new_pos)
-        {
-            message = "Cannot leave board";
-            continue;
-        }
-
-        if (same_side(new_pos, getTurnChar()))
-        {
-            message = "Cannot capture own piece";
-            continue;
-        }
-        else if (is_space(new_pos))
-        {
-            add_piece(o_turn, new_pos, piece_pos & kings);
-            remove_piece(o_turn, piece_pos);
-        }
-        else
-        {
-            uint32_t capture_pos = new_pos;
-            new_pos = move(capture_pos, direction == "l", forward, o_turn);
-
-            if (!new_pos)
-            {
-                message = "Cannot leave board";
-                continue;
-            }
-
-            if (is_space(new_pos))
-            {
-                add_piece(o_turn, new_pos, piece_pos & kings);
-                remove_piece(!o_turn, capture_pos);
-                remove_piece(o_turn, piece_pos);
-
-                piece_pos = new_pos;
-                available_captures(next_capture, piece_pos);
-                if (next_capture[0])
-                {
-                    message = "You can continue capturing";
-                    continue;
-                }
-            }
-            else
-            {
-                message = "Capture blocked";
-                continue;
-            }
-        }
-
-        change_turn();
+        message = game.move_selected(direction == "l", forward);
+        if (message.empty() && game.capturing())
+            message = "You can continue capturing";
     }
 }
@@ -0,0 +1,157 @@
+#include "EndgameDB.h"
+#include <cstring>
+
+using namespace std;
+
+namespace
+{
+    struct Binomials {
+        uint64_t values[33][MAX_EG_PIECES + 1];
+    };
+
+    constexpr Binomials make_binomials()
+    {
+        Binomials binomials = {};
+        for (int n = 0; n <= 32; n++)
+        {
+            binomials.values[n][0] = 1;
+            for (int k = 1; k <= MAX_EG_PIECES && k <= n; k++)
+                binomials.values[n][k] = binomials.values[n - 1][k - 1] + ((k < n) ? binomials.values[n - 1][k] : 0);
+        }
+
+        return binomials;
+    }
+
+    constexpr Binomials BINOMIALS = make_binomials();
+}
+
+const char EndgameDB::MAGIC[8] = { 'C', 'K', 'E', 'G', 'D', 'B', '1', 0 };
+
+EndgameDB::EndgameDB()
+{
+    close();
+}
+
+EndgameDB::~EndgameDB()
+{
+}
+
+bool EndgameDB::open(const string& path)
+{
+    close();
+
+    if (!file.open(path) || file.size() < sizeof(Header))
+        return false;
+
+    Header header;
+    memcpy(&header, file.data(), sizeof(Header));
+    if (memcmp(header.magic, MAGIC, sizeof(MAGIC)) != 0 || header.max_pieces > MAX_EG_PIECES ||
+        file.size() < sizeof(Header) + header.slice_count * sizeof(Slice))
+    {
+        close();
+        return false;
+    }
+
+    for (uint32_t i = 0; i < header.slice_count; i++)
+    {
+        Slice slice;
+        memcpy(&slice, file.data() + sizeof(Header) + i * sizeof(Slice), sizeof(Slice));
+
+        if (slice.x_men + slice.x_kings + slice.o_men + slice.o_kings > (int)header.max_pieces ||
+            slice.offset + 2 * slice.positions > file.size())
+        {
+            close();
+            return false;
+        }
+
+        slices[slice.x_men][slice.x_kings][slice.o_men][slice.o_kings] = file.data() + slice.offset;
+        slice_sizes[slice.x_men][slice.x_kings][slice.o_men][slice.o_kings] = slice.positions;
+    }
+
+    pieces = header.max_pieces;
+    return true;
+}
+
+void EndgameDB::close()
+{
+    file.close();
+    pieces = 0;
+    memset(slices, 0, sizeof(slices));
+    memset(slice_sizes, 0, sizeof(slice_sizes));
+}
+
+EGResult EndgameDB::probe(const uint32_t board[], bool is_o, int& distance) const
+{
+    const int x_men = __builtin_popcount(board[0] & ~board[2]), x_kings = __builtin_popcount(board[0] & board[2]);
+    const int o_men = __builtin_popcount(board[1] & ~board[2]), o_kings = __builtin_popcount(board[1] & board[2]);
+
+    if (x_men + x_kings + o_men + o_kings > pieces || !(x_men + x_kings) || !(o_men + o_kings))
+        return EG_UNKNOWN;
+
+    const uint8_t* slice = slices[x_men][x_kings][o_men][o_kings];
+    if (!slice)
+        return EG_UNKNOWN;
+
+    return decode(slice[is_o * slice_sizes[x_men][x_kings][o_men][o_kings] + position_index(board)], distance);
+}
+
+uint64_t EndgameDB::slice_positions(int x_men, int x_kings, int o_men, int o_kings)
+{
+    return choose(28, x_men) * choose(32, x_kings) * choose(28, o_men) * choose(32, o_kings);
+}
+
+// men never stand on the rank where they would be crowned, so x men are ranked from square 4 and o men below square 28
+uint64_t EndgameDB::position_index(const uint32_t board[])
+{
+    const uint32_t x_kings = board[0] & board[2], o_kings = board[1] & board[2];
+    const uint32_t o_men = board[1] & ~board[2];
+
+    uint64_t index = rank(board[0] & ~board[2], 4);
+    index = index * choose(32, __builtin_popcount(x_kings)) + rank(x_kings, 0);
+    index = index * choose(28, __builtin_popcount(o_men)) + rank(o_men, 0);
+    index = index * choose(32, __builtin_popcount(o_kings)) + rank(o_kings, 0);
+
+    return index;
+}
+
+uint8_t EndgameDB::encode(EGResult result, int distance)
+{
+    if (result != EG_WIN && result != EG_LOSS)
+        return 0;
+
+    // very long results are clamped while keeping who wins
+    if (distance > 253)
+        distance = 253 - ((distance & 1) ^ 1);
+
+    return distance + 1;
+}
+
+EGResult EndgameDB::decode(uint8_t value, int& distance)
+{
+    if (!value)
+    {
+        distance = 0;
+        return EG_DRAW;
+    }
+
+    distance = value - 1;
+    return (distance & 1) ? EG_WIN : EG_LOSS;
+}
+
+uint64_t EndgameDB::choose(int n, int k)
+{
+    if (n < 0 || n > 32 || k < 0 || k > n || k > MAX_EG_PIECES)
+        return 0;
+
+    return BINOMIALS.values[n][k];
+}
+
+// colex rank of a set of squares, sum of choose(square, i) for the i-th lowest square
+uint64_t EndgameDB::rank(uint32_t squares, int offset)
+{
+    uint64_t result = 0;
+    for (int i = 1; squares; i++, squares &= squares - 1)
+        result += choose(__builtin_ctz(squares) - offset, i);
+
+    return result;
+}
@@ -0,0 +1,160 @@
+#include "Evaluation.h"
+#include "BoardGeometry.h"
+#include <fstream>
+
+using namespace std;
+
+namespace
+{
+    // which terms apply to each square, seen from o's side of the board where row 0 is the back rank
+    struct SquarePatterns {
+        int row[32];
+        bool center[32];
+    };
+
+    constexpr SquarePatterns make_patterns()
+    {
+        SquarePatterns patterns = {};
+
+        for (int square = 0; square < 32; square++)
+        {
+            int row = square / 4;
+            int col = (square % 4) * 2 + row % 2;
+
+            patterns.row[square] = row;
+            patterns.center[square] = row >= 2 && row <= 5 && col >= 2 && col <= 5;
+        }
+
+        return patterns;
+    }
+
+    constexpr SquarePatterns PATTERNS = make_patterns();
+
+    struct WeightName {
+        const char* name;
+        int EvalWeights::* weight;
+    };
+
+    const WeightName WEIGHT_NAMES[] = {
+        { "man", &EvalWeights::man },
+        { "king", &EvalWeights::king },
+        { "back_rank", &EvalWeights::back_rank },
+        { "center", &EvalWeights::center },
+        { "advance", &EvalWeights::advance },
+        { "king_mobility", &EvalWeights::king_mobility },
+    };
+}
+
+Evaluation::Evaluation()
+{
+    set_weights(EvalWeights());
+}
+
+Evaluation::Evaluation(const EvalWeights& weights)
+{
+    set_weights(weights);
+}
+
+Evaluation::~Evaluation()
+{
+}
+
+void Evaluation::set_weights(const EvalWeights& weights)
+{
+    this->weights = weights;
+
+    for (int square = 0; square < 32; square++)
+    {
+        // x plays down the board, so its squares are looked up mirrored
+        const int mirrored = 31 - square;
+        const int center = weights.center;
+
+        int o_man = weights.man + weights.advance * PATTERNS.row[square];
+        int x_man = weights.man + weights.advance * PATTERNS.row[mirrored];
+        if (PATTERNS.row[square] == 0)
+            o_man += weights.back_rank;
+        if (PATTERNS.row[mirrored] == 0)
+            x_man += weights.back_rank;
+
+        table[0][square] = x_man + (PATTERNS.center[mirrored] ? center : 0);
+        table[1][square] = -(o_man + (PATTERNS.center[square] ? center : 0));
+        table[2][square] = weights.king + (PATTERNS.center[mirrored] ? center : 0);
+        table[3][square] = -(weights.king + (PATTERNS.center[square] ? center : 0));
+    }
+}
+
+int Evaluation::score_pieces(int piece, uint32_t pieces) const
+{
+    int score = 0;
+    for (; pieces; pieces &= pieces - 1)
+        score += table[piece][__builtin_ctz(pieces)];
+
+    return score;
+}
+
+int Evaluation::score(const uint32_t board[]) const
+{
+    return score_pieces(0, board[0] & ~board[2]) + score_pieces(1, board[1] & ~board[2]) +
+           score_pieces(2, board[0] & board[2]) + score_pieces(3, board[1] & board[2]);
+}
+
+// empty squares next to each side's kings, counted every time since any move can change them
+int Evaluation::mobility(const uint32_t board[]) const
+{
+    const uint32_t empty = ~(board[0] | board[1]);
+    const uint32_t x_kings = board[0] & board[2], o_kings = board[1] & board[2];
+
+    if (!(x_kings | o_kings))
+        return 0;
+
+    int count = 0;
+    for (int dir = 0; dir < 4; dir++)
+    {
+        const bool left = dir & 1, up = dir & 2;
+        count += __builtin_popcount(shift(x_kings, left, up) & empty) - __builtin_popcount(shift(o_kings, left, up) & empty);
+    }
+
+    return count * weights.king_mobility;
+}
+
+// weights missing from the file keep their value, an unknown name fails the whole file
+bool Evaluation::load_weights(const string& path, EvalWeights& weights)
+{
+    ifstream in(path);
+    if (!in)
+        return false;
+
+    EvalWeights loaded = weights;
+    string name;
+    int value;
+    while (in >> name >> value)
+    {
+        bool known = false;
+        for (const WeightName& entry : WEIGHT_NAMES)
+        {
+            if (name == entry.name)
+            {
+                loaded.*entry.weight = value;
+                known = true;
+            }
+        }
+
+        if (!known)
+            return false;
+    }
+
+    if (!in.eof())
+        return false;
+
+    weights = loaded;
+    return true;
+}
+
+bool Evaluation::save_weights(const string& path, const EvalWeights& weights)
+{
+    ofstream out(path);
+    for (const WeightName& entry : WEIGHT_NAMES)
+        out << entry.name << " " << weights.*entry.weight << "\n";
+
+    return (bool)out;
+}
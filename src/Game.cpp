@@ -0,0 +1,327 @@
+#include "Game.h"
+#include <sstream>
+
+using namespace std;
+
+Game::Game() : playerAI(new PlayerAI(board[1], board[0], board[2]))
+{
+}
+
+Game::Game(shared_ptr<TranspositionTable> table) : playerAI(new PlayerAI(board[1], board[0], board[2], table))
+{
+}
+
+char Game::turn_char()
+{
+    return o_turn ? O_PIECE : X_PIECE;
+}
+
+char Game::winner()
+{
+    if (o_wins)
+        return O_PIECE;
+    if (x_wins)
+        return X_PIECE;
+    return SPACE;
+}
+
+string Game::select_piece(int row, int col)
+{
+    if (o_wins || x_wins)
+        return "The game is over";
+
+    if (col < 1 || col > 8 || row < 1 || row > 8)
+        return "Expected valid column and row numbers";
+
+    col = col - 1 - (row % 2);
+    if (col % 2 == 1)
+        return "Empty square chosen";
+
+    col = col / 2;
+    row = 8 - row;
+    piece_pos = 1 << (row * 4 + col);
+
+    if (is_space(piece_pos))
+        return "Empty square chosen";
+    if (!same_side(piece_pos, turn_char()))
+        return "Enemy piece chosen";
+
+    return "";
+}
+
+string Game::move_selected(bool left, bool forward)
+{
+    if (!forward && !selected_king())
+        return "Only kings can move backwards";
+
+    uint32_t new_pos = move(piece_pos, left, forward);
+    if (!new_pos)
+        return "Cannot leave board";
+
+    if (same_side(new_pos, turn_char()))
+        return "Cannot capture own piece";
+
+    if (is_space(new_pos))
+    {
+        add_piece(o_turn, new_pos, piece_pos & board[2]);
+        remove_piece(o_turn, piece_pos);
+        change_turn();
+        return "";
+    }
+
+    uint32_t capture_pos = new_pos;
+    new_pos = move(capture_pos, left, forward, o_turn);
+    if (!new_pos)
+        return "Cannot leave board";
+    if (!is_space(new_pos))
+        return "Capture blocked";
+
+    add_piece(o_turn, new_pos, piece_pos & board[2]);
+    remove_piece(!o_turn, capture_pos);
+    remove_piece(o_turn, piece_pos);
+
+    piece_pos = new_pos;
+    available_captures(next_capture, piece_pos);
+    if (!next_capture[0])
+        change_turn();
+
+    return "";
+}
+
+string Game::continue_capture(bool left, bool forward)
+{
+    // men only fill in the forward directions
+    if ((!forward && !selected_king()) || !next_capture[(left ? 1 : 2) + (forward ? 0 : 2)])
+        return "No capture in that direction";
+
+    uint32_t capture_pos = move(piece_pos, left, forward);
+    uint32_t new_pos = move(capture_pos, left, forward, o_turn);
+
+    add_piece(o_turn, new_pos, piece_pos & board[2]);
+    remove_piece(!o_turn, capture_pos);
+    remove_piece(o_turn, piece_pos);
+
+    piece_pos = new_pos;
+    available_captures(next_capture, piece_pos);
+    if (!next_capture[0])
+        change_turn();
+
+    return "";
+}
+
+// captures are optional, the turn passes without promoting as in the console game
+void Game::finish_capture()
+{
+    o_turn = !o_turn;
+    next_capture[0] = false;
+}
+
+uint32_t Game::engine_move(bool ponder)
+{
+    playerAI->next_move(!o_turn, board[1], board[0], board[2], o_wins, x_wins);
+    board[0] = playerAI->x_board();
+    board[1] = playerAI->o_board();
+    board[2] = playerAI->kings();
+
+    change_turn();
+
+    // the side that just moved is max_player when it is o to move
+    if (ponder && !o_wins && !x_wins)
+        playerAI->start_pondering(o_turn);
+
+    return playerAI->last_move();
+}
+
+string Game::board_string()
+{
+    ostringstream str_stream;
+    str_stream << "\n     1   2   3   4   5   6   7   8\n";
+    str_stream << "    --------------------------------\n";
+
+    bool even = false;
+    int row_num = 1;
+    int col_cycle = 0;
+    char piece;
+    for (uint32_t pos = 1 << 28; pos; pos >>= 4)
+    {
+        str_stream << " " << row_num << " ";
+        if (!even)
+            str_stream << "| ";
+
+        for (col_cycle = 0; col_cycle < 4; col_cycle++)
+        {
+            piece = get_piece(pos << col_cycle);
+            if (even)
+                str_stream << "| " << piece << " | " << SPACE << " ";
+            else
+                str_stream << SPACE << " | " << piece << " | ";
+        }
+
+        if (even)
+            str_stream << "|";
+
+        str_stream << "\n    --------------------------------\n";
+        even = !even;
+        row_num++;
+    }
+
+    return str_stream.str();
+}
+
+string Game::square_name(uint32_t pos)
+{
+    int bit = 0;
+    while (pos >>= 1)
+        bit++;
+
+    int row = 8 - bit / 4;
+    int col = (bit % 4) * 2 + 1 + (row % 2);
+    return to_string(row) + "," + to_string(col);
+}
+
+string Game::move_name(uint32_t move, uint32_t player, uint32_t opponent)
+{
+    uint32_t from = move & player, captures = move & opponent;
+    uint32_t to = move & ~player & ~opponent;
+
+    // a capture sequence can end on the square it started from
+    if (!to)
+        to = from;
+
+    return square_name(from) + (captures ? "x" : "-") + square_name(to);
+}
+
+bool Game::is_space(uint32_t pos)
+{
+    return pos & ~(board[1] + board[0]);
+}
+
+char Game::get_king_side(char king)
+{
+    if (king == O_KING)
+        return O_PIECE;
+    else if (king == X_KING)
+        return X_PIECE;
+    else
+        return king;
+}
+
+bool Game::same_side(uint32_t pos, char piece)
+{
+    piece = get_king_side(piece);
+    return
+        (piece == O_PIECE && (board[1] & pos)) ||
+        (piece == X_PIECE && (board[0] & pos));
+}
+
+void Game::add_piece(bool is_o, uint32_t pos, bool is_king)
+{
+    board[is_o] |= pos;
+
+    if (is_king)
+        board[2] |= pos;
+}
+
+void Game::remove_piece(bool is_o, uint32_t pos)
+{
+    board[is_o] &= ~pos;
+    board[2] &= ~pos;
+}
+
+// return 0 if move is out of bounds
+uint32_t Game::move(uint32_t pos, bool left, bool forward, bool o_turn)
+{
+    return shift(pos, left, o_turn == forward);
+}
+
+uint32_t Game::move(uint32_t pos, bool left, bool forward)
+{
+    return move(pos, left, forward, same_side(pos, O_PIECE));
+}
+
+char Game::get_piece(uint32_t pos)
+{
+    char piece = (pos & board[1]) ? O_KING : ((pos & board[0]) ? X_KING : SPACE);
+    return (pos & board[2]) ? piece : get_king_side(piece);
+}
+
+// left and forward always first [lf, rf, lb, rb]
+void Game::available_captures(bool* captures, uint32_t pos)
+{
+    bool is_o = same_side(pos, O_PIECE);
+    uint32_t opponent = board[!is_o];
+
+    captures[0] = false;
+    const int direction_count = (pos & board[2]) ? 4 : 2;
+    bool left = true, forward = true;
+    uint32_t capture_pos, new_pos;
+    for (int i = 0; i < direction_count; i++)
+    {
+        captures[i + 1] = false;
+        capture_pos = move(pos, left, forward);
+        if (capture_pos && (opponent & capture_pos))
+        {
+            new_pos = move(capture_pos, left, forward, is_o);
+            if (new_pos && is_space(new_pos))
+            {
+                captures[i + 1] = true;
+                captures[0] = true;
+            }
+        }
+
+        left = !left;
+        if (left)
+            forward = !forward;
+    }
+}
+
+bool Game::has_move(uint32_t pos)
+{
+    bool o_turn = same_side(pos, O_PIECE);
+    uint32_t opponent = board[!o_turn];
+
+    const char direction_count = (pos & board[2]) ? 4 : 2;
+    bool left = true, forward = true;
+    uint32_t new_pos;
+    for (char i = 0; i < direction_count; i++)
+    {
+        new_pos = move(pos, left, forward);
+        if (is_space(new_pos))
+            return true;
+        else if (new_pos & opponent)
+        {
+            new_pos = move(new_pos, left, forward, o_turn);
+            if (is_space(new_pos))
+                return true;
+        }
+
+        left = !left;
+        if (left)
+            forward = !forward;
+    }
+
+    return false;
+}
+
+bool Game::is_winner(bool o_turn)
+{
+    uint32_t opponent = board[!o_turn];
+    for (uint32_t pos = 1; pos != 0; pos <<= 1)
+        if ((pos & opponent) && has_move(pos))
+            return false;
+
+    return true;
+}
+
+void Game::change_turn()
+{
+    uint32_t king_rank = o_turn ? X_BACK_RANK : O_BACK_RANK;
+    board[2] |= board[o_turn] & king_rank;
+
+    if (o_turn)
+        o_wins = is_winner(o_turn);
+    else
+        x_wins = is_winner(o_turn);
+
+    o_turn = !o_turn;
+}
@@ -0,0 +1,322 @@
+#include "GameServer.h"
+#include <iostream>
+#include <sstream>
+#include <cerrno>
+
+#ifndef _WIN32
+#include <poll.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <sys/stat.h>
+#endif
+
+// longest line a client may send before its connection is dropped
+#define MAX_LINE 4096
+
+// table of each game when there is no shared one, small since a server may host thousands of games
+#define SESSION_TABLE_MB 1
+
+using namespace std;
+
+GameServer::GameServer(const string& path, int threads, SearchLimits limits, size_t shared_table_mb) :
+    path(path), threads(threads), limits(limits), session_table_mb(SESSION_TABLE_MB)
+{
+    if (shared_table_mb > 0)
+        table = make_shared<TranspositionTable>(shared_table_mb);
+
+    databases.reset(new PlayerAI(0, 0, 0, make_shared<TranspositionTable>(1)));
+}
+
+GameServer::~GameServer()
+{
+    stop();
+}
+
+#ifdef _WIN32
+
+bool GameServer::run()
+{
+    cerr << "the game server needs unix sockets" << endl;
+    return false;
+}
+
+void GameServer::accept_client() {}
+void GameServer::read_client(shared_ptr<Session> session) {}
+void GameServer::close_session(shared_ptr<Session> session) {}
+
+#else
+
+bool GameServer::run()
+{
+    sockaddr_un address = {};
+    address.sun_family = AF_UNIX;
+    if (path.size() >= sizeof(address.sun_path))
+        return false;
+    path.copy(address.sun_path, path.size());
+
+    listen_fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (listen_fd < 0)
+        return false;
+
+    if (!remove_socket())
+    {
+        close(listen_fd);
+        return false;
+    }
+    if (bind(listen_fd, (sockaddr*)&address, sizeof(address)) < 0 || listen(listen_fd, SOMAXCONN) < 0)
+    {
+        close(listen_fd);
+        return false;
+    }
+
+    running = true;
+    for (int i = 0; i < threads; i++)
+        workers.emplace_back(&GameServer::worker, this);
+
+    vector<pollfd> fds;
+    vector<shared_ptr<Session>> polled;
+    while (running)
+    {
+        fds.assign(1, { listen_fd, POLLIN, 0 });
+        polled.clear();
+        {
+            lock_guard<mutex> guard(lock);
+            for (auto it = sessions.begin(); it != sessions.end(); )
+            {
+                shared_ptr<Session> session = (it++)->second;
+                if (session->closed)
+                    close_session(session);
+                else
+                {
+                    fds.push_back({ session->fd, POLLIN, 0 });
+                    polled.push_back(session);
+                }
+            }
+        }
+
+        // the timeout only bounds how long stop takes
+        if (poll(fds.data(), fds.size(), 100) <= 0)
+            continue;
+
+        if (fds[0].revents & POLLIN)
+            accept_client();
+
+        for (size_t i = 1; i < fds.size(); i++)
+            if (fds[i].revents)
+                read_client(polled[i - 1]);
+    }
+
+    {
+        lock_guard<mutex> guard(lock);
+        work.clear();
+    }
+    work_ready.notify_all();
+    for (thread& worker_thread : workers)
+        worker_thread.join();
+    workers.clear();
+
+    for (auto& entry : sessions)
+        close(entry.first);
+    sessions.clear();
+
+    close(listen_fd);
+    remove_socket();
+    return true;
+}
+
+// a socket left at the path by an earlier run is removed, anything else there is an error rather than deleted
+bool GameServer::remove_socket()
+{
+    struct stat info;
+    if (lstat(path.c_str(), &info) < 0)
+        return errno == ENOENT;
+
+    if (!S_ISSOCK(info.st_mode))
+    {
+        cerr << path << " exists and is not a socket" << endl;
+        return false;
+    }
+
+    return unlink(path.c_str()) == 0;
+}
+
+void GameServer::accept_client()
+{
+    int fd = accept(listen_fd, nullptr, nullptr);
+    if (fd < 0)
+        return;
+
+    shared_ptr<Session> session = make_shared<Session>();
+    session->fd = fd;
+    session->game.reset(new Game(table ? table : make_shared<TranspositionTable>(session_table_mb)));
+    session->game->engine().set_limits(limits);
+    session->game->engine().share_databases(*databases);
+
+    lock_guard<mutex> guard(lock);
+    sessions[fd] = session;
+}
+
+// only the polling thread closes a session's fd, so it stays open for recv even if a worker marked it closed meanwhile
+void GameServer::read_client(shared_ptr<Session> session)
+{
+    char buffer[4096];
+    ssize_t length = recv(session->fd, buffer, sizeof(buffer), 0);
+
+    lock_guard<mutex> guard(lock);
+    if (length <= 0 || session->closed)
+    {
+        close_session(session);
+        return;
+    }
+
+    session->input.append(buffer, length);
+    size_t start = 0, end;
+    while ((end = session->input.find('\n', start)) != string::npos)
+    {
+        string line = session->input.substr(start, end - start);
+        if (!line.empty() && line.back() == '\r')
+            line.pop_back();
+        session->lines.push_back(line);
+        start = end + 1;
+    }
+    session->input.erase(0, start);
+
+    if (session->input.size() > MAX_LINE)
+    {
+        close_session(session);
+        return;
+    }
+
+    if (!session->busy && !session->lines.empty())
+    {
+        session->busy = true;
+        work.push_back(session);
+        work_ready.notify_one();
+    }
+}
+
+// called by the polling thread with the lock held, a session a worker is playing is closed on a later pass once
+// the worker is done with it
+void GameServer::close_session(shared_ptr<Session> session)
+{
+    session->closed = true;
+    if (session->busy)
+        return;
+
+    sessions.erase(session->fd);
+    close(session->fd);
+}
+
+#endif
+
+void GameServer::worker()
+{
+    while (true)
+    {
+        shared_ptr<Session> session;
+        {
+            unique_lock<mutex> guard(lock);
+            work_ready.wait(guard, [this] { return !work.empty() || !running; });
+            if (!running)
+                return;
+
+            session = work.front();
+            work.pop_front();
+        }
+
+        // the lines that came in meanwhile are played before the session goes back to the poller
+        while (true)
+        {
+            string line;
+            {
+                lock_guard<mutex> guard(lock);
+                if (session->closed || session->lines.empty() || !running)
+                {
+                    session->busy = false;
+                    break;
+                }
+
+                line = session->lines.front();
+                session->lines.pop_front();
+            }
+
+            string reply = play(*session, line) + "\n";
+#ifndef _WIN32
+            if (send(session->fd, reply.data(), reply.size(), MSG_NOSIGNAL) < 0)
+            {
+                lock_guard<mutex> guard(lock);
+                session->closed = true;
+            }
+#endif
+        }
+    }
+}
+
+// every reply is one line, "error <message>" or "ok" followed by the state, and the move name for "engine"
+string GameServer::play(Session& session, const string& line)
+{
+    Game& game = *session.game;
+    istringstream in(line);
+    string command, direction, forward;
+    in >> command;
+
+    if (command == "board")
+        return "ok " + state(game);
+
+    if (command == "move")
+    {
+        int row = 0, col = 0;
+        in >> row >> col >> direction >> forward;
+        if (direction != "l" && direction != "r")
+            return "error Movement should be L (left) or R (right)";
+        if (game.capturing())
+            return "error Finish the capture first";
+
+        string message = game.select_piece(row, col);
+        if (message.empty())
+            message = game.move_selected(direction == "l", forward != "b");
+        return message.empty() ? "ok " + state(game) : "error " + message;
+    }
+
+    if (command == "capture")
+    {
+        in >> direction >> forward;
+        if (!game.capturing())
+            return "error No capture to continue";
+        if (direction == "n")
+        {
+            game.finish_capture();
+            return "ok " + state(game);
+        }
+        if (direction != "l" && direction != "r")
+            return "error Movement should be N to finish or L or R";
+
+        string message = game.continue_capture(direction == "l", forward != "b");
+        return message.empty() ? "ok " + state(game) : "error " + message;
+    }
+
+    if (command == "engine")
+    {
+        if (game.winner() != SPACE)
+            return "error The game is over";
+        if (game.capturing())
+            return "error Finish the capture first";
+
+        bool o_turn = game.is_o_turn();
+        uint32_t player = o_turn ? game.o_board() : game.x_board(), opponent = o_turn ? game.x_board() : game.o_board();
+        uint32_t move = game.engine_move(false);
+        return "ok " + state(game) + " " + Game::move_name(move, player, opponent);
+    }
+
+    return "error Unknown command " + command;
+}
+
+// x_board o_board kings, the side to move, the winner or *, and capture while the same piece may jump again
+string GameServer::state(Game& game)
+{
+    ostringstream out;
+    out << game.x_board() << " " << game.o_board() << " " << game.kings() << " " << (game.is_o_turn() ? "o" : "x")
+        << " " << game.winner() << (game.capturing() ? " capture" : "");
+    return out.str();
+}
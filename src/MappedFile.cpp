@@ -0,0 +1,116 @@
+#include "MappedFile.h"
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
+using namespace std;
+
+MappedFile::MappedFile()
+{
+}
+
+MappedFile::~MappedFile()
+{
+    close();
+}
+
+#ifdef _WIN32
+
+bool MappedFile::open(const string& path)
+{
+    close();
+
+    HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+    if (file == INVALID_HANDLE_VALUE)
+        return false;
+
+    LARGE_INTEGER file_size;
+    if (!GetFileSizeEx(file, &file_size) || file_size.QuadPart == 0)
+    {
+        CloseHandle(file);
+        return false;
+    }
+
+    HANDLE mapping = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+    if (!mapping)
+    {
+        CloseHandle(file);
+        return false;
+    }
+
+    void* view = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+    if (!view)
+    {
+        CloseHandle(mapping);
+        CloseHandle(file);
+        return false;
+    }
+
+    file_handle = file;
+    mapping_handle = mapping;
+    bytes = (const uint8_t*)view;
+    length = (size_t)file_size.QuadPart;
+
+    return true;
+}
+
+void MappedFile::close()
+{
+    if (bytes)
+        UnmapViewOfFile(bytes);
+    if (mapping_handle)
+        CloseHandle(mapping_handle);
+    if (file_handle)
+        CloseHandle(file_handle);
+
+    bytes = nullptr;
+    length = 0;
+    file_handle = mapping_handle = nullptr;
+}
+
+#else
+
+bool MappedFile::open(const string& path)
+{
+    close();
+
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0)
+        return false;
+
+    struct stat file_stat;
+    if (fstat(fd, &file_stat) != 0 || file_stat.st_size == 0)
+    {
+        ::close(fd);
+        return false;
+    }
+
+    // the mapping stays valid after the descriptor is closed
+    void* view = mmap(nullptr, file_stat.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    ::close(fd);
+
+    if (view == MAP_FAILED)
+        return false;
+
+    bytes = (const uint8_t*)view;
+    length = file_stat.st_size;
+
+    return true;
+}
+
+void MappedFile::close()
+{
+    if (bytes)
+        munmap((void*)bytes, length);
+
+    bytes = nullptr;
+    length = 0;
+}
+
+#endif
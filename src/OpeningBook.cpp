@@ -0,0 +1,63 @@
+#include "OpeningBook.h"
+#include <cstring>
+
+using namespace std;
+
+const char OpeningBook::MAGIC[8] = { 'C', 'K', 'B', 'O', 'O', 'K', '1', 0 };
+
+OpeningBook::OpeningBook()
+{
+}
+
+OpeningBook::~OpeningBook()
+{
+}
+
+bool OpeningBook::open(const string& path)
+{
+    close();
+
+    if (!file.open(path) || file.size() < sizeof(Header))
+        return false;
+
+    // the count is checked by division, a corrupt count times the entry size could wrap around
+    Header header;
+    memcpy(&header, file.data(), sizeof(Header));
+    if (memcmp(header.magic, MAGIC, sizeof(MAGIC)) != 0 || header.count > (file.size() - sizeof(Header)) / sizeof(Entry))
+    {
+        close();
+        return false;
+    }
+
+    // the header keeps the entries 8 byte aligned within the page aligned mapping
+    entries = (const Entry*)(file.data() + sizeof(Header));
+    count = header.count;
+
+    return true;
+}
+
+void OpeningBook::close()
+{
+    file.close();
+    entries = nullptr;
+    count = 0;
+}
+
+bool OpeningBook::probe(uint64_t key, Entry& entry) const
+{
+    uint64_t low = 0, high = count;
+    while (low < high)
+    {
+        uint64_t middle = low + (high - low) / 2;
+        if (entries[middle].key < key)
+            low = middle + 1;
+        else
+            high = middle;
+    }
+
+    if (low == count || entries[low].key != key)
+        return false;
+
+    entry = entries[low];
+    return true;
+}
@@ -1,51 +1,145 @@
 #include "PlayerAI.h"
-#include <vector>
-#include <unordered_map>
+#include <cassert>
 #include <cfloat>
+#include <cmath>
 #include <algorithm>
 
-#define USE_ALPHABETA true
+#define ALGORITHM SEARCH_PVS
 #define DEPTH 11
+#define TT_SIZE_MB 32
+#define THREADS 1
+#define QUIESCENCE true
+#define SEARCH_STATS true
+
+// half the width of the first window around the previous iteration's score, a man is worth 3
+#define ASPIRATION_WINDOW 0.5f
+
+// late move reductions and futility pruning, see Selectivity in PlayerAI.h
+#define LMR true
+#define LMR_DEPTH 3
+#define LMR_MOVES 3
+#define LMR_REDUCTION 1
+#define FUTILITY true
+#define FUTILITY_DEPTH 2
+#define FUTILITY_MARGIN 1.0f
 
 using namespace std;
 
-PlayerAI::PlayerAI(uint32_t o_board, uint32_t x_board, uint32_t kings)
+namespace
+{
+    // the square one step and two steps away from every square in every direction, 0 off the board.
+    // directions are up left, up right, down left and down right, up being the way o moves
+    struct SquareTables {
+        uint32_t neighbour[32][4];
+        uint32_t jump[32][4];
+    };
+
+    constexpr SquareTables make_square_tables()
+    {
+        SquareTables tables = {};
+
+        for (int square = 0; square < 32; square++)
+            for (int dir = 0; dir < 4; dir++)
+            {
+                const bool left = !(dir & 1), up = !(dir & 2);
+                const uint32_t neighbour = shift(1u << square, left, up);
+
+                tables.neighbour[square][dir] = neighbour;
+                tables.jump[square][dir] = shift(neighbour, left, up);
+            }
+
+        return tables;
+    }
+
+    constexpr SquareTables SQUARES = make_square_tables();
+}
+
+PlayerAI::PlayerAI(uint32_t o_board, uint32_t x_board, uint32_t kings) : PlayerAI(o_board, x_board, kings, make_shared<TranspositionTable>(TT_SIZE_MB))
 {
+}
+
+PlayerAI::PlayerAI(uint32_t o_board, uint32_t x_board, uint32_t kings, shared_ptr<TranspositionTable> table) : table(table), history()
+{
+    set_limits({ DEPTH, 0, 0 });
+    set_threads(THREADS);
+    set_algorithm(ALGORITHM);
+    set_selectivity({ LMR, LMR_DEPTH, LMR_MOVES, LMR_REDUCTION, FUTILITY, FUTILITY_DEPTH, FUTILITY_MARGIN });
+    reserve_lines();
+    // one entry per iteration, and the deepest iteration is below MAX_PLY
+    stats.iterations.reserve(MAX_PLY);
     update(o_board, x_board, kings, false, false);
 }
 
+// helpers search without limits until the main search stops them
+PlayerAI::PlayerAI(shared_ptr<TranspositionTable> table) : table(table), history()
+{
+    set_limits({ 0, 0, 0 });
+    reserve_lines();
+    update(0, 0, 0, false, false);
+}
+
 PlayerAI::~PlayerAI()
 {
+    join_search();
+    stop_pondering();
 }
 
 void PlayerAI::minimax(int depth, bool max_player)
 {
-    uint32_t best_move = minimax(this->board, depth, max_player).move;
-    simulate_move(this->board, this->board, best_move, !max_player, true);
+    new_search();
+    set_search_board(max_player);
+    ScoreMovePair result = minimax(search_board, depth, 0, max_player);
+
+    root_move = result.move;
+    root_score = result.score;
+    root_depth = depth;
+    set_single_line(root_move, root_score);
+
+    if (SEARCH_STATS)
+    {
+        chrono::duration<double, milli> elapsed = chrono::steady_clock::now() - start_time;
+        stats.nodes = nodes;
+        stats.time_ms = elapsed.count();
+    }
+
+    simulate_move(this->board, this->board, root_move, !max_player, true);
 }
 
-ScoreMovePair PlayerAI::minimax(uint32_t board[], int depth, bool max_player)
+ScoreMovePair PlayerAI::minimax(uint32_t board[], int depth, int ply, bool max_player)
 {
     ScoreMovePair result;
 
+    nodes++;
+    if (ply == MAX_PLY - 1 || (depth == 0 && !QUIESCENCE))
+    {
+        result.score = evaluate(board, search_eval);
+        return result;
+    }
+
+    // leaves are scored the way alphabeta scores them, so node counts compare the same trees. With a full window
+    // the quiescence search prunes nothing either
     if (depth == 0)
     {
-        result.score = evaluate(board);
+        result.move = 0;
+        result.score = quiescence(board, ply, max_player, -FLT_MAX, FLT_MAX);
         return result;
     }
 
     float evalLimit;
-    uint32_t best_move;
+    uint32_t best_move = 0;
+
+    MoveList& moves = ply_moves[ply];
+    get_all_moves(board, !max_player, moves);
 
     if (max_player)
     {
         evalLimit = -FLT_MAX;
-        for (uint32_t move : get_all_moves(board, false))
+        for (uint32_t move : moves)
         {
-            uint32_t temp_board[3];
-            simulate_move(board, temp_board, move, false, true);
-
-            float evaluation = minimax(temp_board, depth - 1, false).score;
+            UndoRecord& undo = undo_stack[ply];
+            make_move(board, move, false, undo);
+            float evaluation = minimax(board, depth - 1, ply + 1, false).score;
+            unmake_move(board, move, false, undo);
             if (evalLimit < evaluation)
                 best_move = move;
 
@@ -55,12 +149,12 @@ ScoreMovePair PlayerAI::minimax(uint32_t board[], int depth, bool max_player)
     else
     {
         evalLimit = FLT_MAX;
-        for (uint32_t move : get_all_moves(board, true))
+        for (uint32_t move : moves)
         {
-            uint32_t temp_board[3];
-            simulate_move(board, temp_board, move, true, true);
-
-            float evaluation = minimax(temp_board, depth - 1, true).score;
+            UndoRecord& undo = undo_stack[ply];
+            make_move(board, move, true, undo);
+            float evaluation = minimax(board, depth - 1, ply + 1, true).score;
+            unmake_move(board, move, true, undo);
             if (evalLimit > evaluation)
                 best_move = move;
 
@@ -69,39 +163,519 @@ ScoreMovePair PlayerAI::minimax(uint32_t board[], int depth, bool max_player)
     }
 
     result.move = best_move;
-    result.score = best_move ? evalLimit : evaluate(board);
+    result.score = best_move ? evalLimit : evaluate(board, search_eval);
 
     return result;
 }
 
-void PlayerAI::alphabeta(int depth, bool max_player)
+void PlayerAI::iterative_deepening(bool max_player)
+{
+    new_search();
+    search(max_player);
+    simulate_move(this->board, this->board, root_move, !max_player, true);
+}
+
+// resets the search state, done before a pondering thread starts so that thread only reads it
+void PlayerAI::new_search()
+{
+    table->new_search();
+    clear_ordering();
+    start_time = chrono::steady_clock::now();
+    nodes = 0;
+    stopped = can_stop = false;
+    root_move = 0;
+    root_score = 0;
+    root_depth = 0;
+    line_count = 0;
+
+    if (SEARCH_STATS)
+        stats.clear();
+}
+
+// the best move of the deepest finished iteration is kept, earlier iterations order the later ones through the table
+void PlayerAI::search(bool max_player)
+{
+    const int max_depth = (limits.depth > 0) ? min(limits.depth, MAX_PLY - 1) : MAX_PLY - 1;
+
+    set_search_board(max_player);
+    start_helpers(max_player);
+
+    for (int depth = 1; depth <= max_depth; depth++)
+    {
+        ScoreMovePair result = (multi_pv > 1) ? multi_pv_search(depth, max_player) : aspiration_search(depth, max_player);
+        if (stopped || !result.move)
+            break;
+
+        root_move = result.move;
+        root_score = result.score;
+        root_depth = depth;
+        can_stop = true;
+
+        if (multi_pv <= 1)
+            set_single_line(result.move, result.score);
+        for (int rank = 0; rank < line_count; rank++)
+            principal_variation(lines[rank].pv, lines[rank].move, max_player, depth);
+
+        chrono::duration<double, milli> elapsed = chrono::steady_clock::now() - start_time;
+        if (SEARCH_STATS)
+            stats.iterations.push_back({ depth, nodes, elapsed.count(), result.score, result.move });
+        {
+            lock_guard<mutex> guard(progress_lock);
+            if (progress)
+                progress({ depth, nodes, elapsed.count(), result.score, result.move });
+        }
+
+        // an iteration takes longer than all previous ones together, so don't start one that can't finish
+        if (pondering)
+            continue;
+        if (cancelled || (limits.time_ms && elapsed.count() * 2 > limits.time_ms))
+            break;
+    }
+
+    stop_helpers();
+
+    if (SEARCH_STATS)
+    {
+        chrono::duration<double, milli> elapsed = chrono::steady_clock::now() - start_time;
+        stats.nodes = nodes;
+        stats.time_ms = elapsed.count();
+    }
+}
+
+// pvs iterations start with a narrow window around the last score, a side that fails is opened up and searched again
+ScoreMovePair PlayerAI::aspiration_search(int depth, bool max_player)
+{
+    if (algorithm != SEARCH_PVS || depth < 4)
+        return alphabeta(search_board, depth, 0, max_player, -FLT_MAX, FLT_MAX);
+
+    float window = ASPIRATION_WINDOW;
+    float alpha = root_score - window, beta = root_score + window;
+    while (true)
+    {
+        ScoreMovePair result = alphabeta(search_board, depth, 0, max_player, alpha, beta);
+        if (stopped)
+            return result;
+
+        window *= 4;
+        if (result.score <= alpha)
+            alpha = result.score - window;
+        else if (result.score >= beta)
+            beta = result.score + window;
+        else
+            return result;
+    }
+}
+
+// every line is a search of the root without the moves of the lines before it, with an aspiration window around
+// the score that line had in the last iteration, so each one costs about as much as a single pv search of what's left
+ScoreMovePair PlayerAI::multi_pv_search(int depth, bool max_player)
+{
+    int found = 0;
+    for (int rank = 0; rank < multi_pv; rank++)
+    {
+        const bool aspiration = depth >= 4 && rank < line_count;
+        float window = ASPIRATION_WINDOW;
+        float alpha = aspiration ? lines[rank].score - window : -FLT_MAX;
+        float beta = aspiration ? lines[rank].score + window : FLT_MAX;
+
+        ScoreMovePair result;
+        while (true)
+        {
+            result = root_search(depth, max_player, alpha, beta, found);
+            if (stopped)
+                return result;
+
+            window *= 4;
+            if (result.move && result.score <= alpha)
+                alpha = result.score - window;
+            else if (result.move && result.score >= beta)
+                beta = result.score + window;
+            else
+                break;
+        }
+
+        // fewer root moves than lines
+        if (!result.move)
+            break;
+        found_lines[found].move = result.move;
+        found_lines[found].score = result.score;
+        found++;
+    }
+
+    ScoreMovePair result = { 0, 0 };
+    if (!found)
+        return result;
+
+    swap(lines, found_lines);
+    line_count = found;
+    result.move = lines[0].move;
+    result.score = lines[0].score;
+    return result;
+}
+
+// pvs over the root moves that aren't among the first excluded found lines, the lines of the last iteration ordered first
+ScoreMovePair PlayerAI::root_search(int depth, bool max_player, float alpha, float beta, int excluded)
+{
+    ScoreMovePair result = { 0, 0 };
+    uint32_t* board = search_board;
+
+    MoveList& moves = ply_moves[0];
+    get_all_moves(board, !max_player, moves);
+    order_moves(board, !max_player, 0, root_move, moves);
+    for (int i = 0; i < moves.size(); i++)
+        for (int rank = 0; rank < line_count; rank++)
+            if (moves[i] == lines[rank].move)
+                moves.scores[i] = (1 << 30) - rank;
+
+    float best = max_player ? -FLT_MAX : FLT_MAX;
+    int searched = 0;
+    for (int i = 0; i < moves.size(); i++)
+    {
+        uint32_t move = moves.pick(i);
+        if (any_of(found_lines.begin(), found_lines.begin() + excluded, [&](const RootLine& line) { return line.move == move; }))
+            continue;
+
+        UndoRecord& undo = undo_stack[0];
+        make_move(board, move, !max_player, undo);
+        float evaluation;
+        if (max_player)
+        {
+            evaluation = searched ? alphabeta(board, depth - 1, 1, false, alpha, nextafterf(alpha, FLT_MAX)).score : FLT_MAX;
+            if (evaluation > alpha && !stopped)
+                evaluation = alphabeta(board, depth - 1, 1, false, alpha, beta).score;
+        }
+        else
+        {
+            evaluation = searched ? alphabeta(board, depth - 1, 1, true, nextafterf(beta, -FLT_MAX), beta).score : -FLT_MAX;
+            if (evaluation < beta && !stopped)
+                evaluation = alphabeta(board, depth - 1, 1, true, alpha, beta).score;
+        }
+        unmake_move(board, move, !max_player, undo);
+        searched++;
+
+        if (stopped)
+            return result;
+
+        if (!result.move || (max_player ? evaluation > best : evaluation < best))
+        {
+            best = evaluation;
+            result.move = move;
+        }
+
+        if (max_player)
+            alpha = max(alpha, best);
+        else
+            beta = min(beta, best);
+        if (beta <= alpha)
+            break;
+    }
+
+    result.score = best;
+    return result;
+}
+
+// the line the table expects after a root move, followed while its moves are legal. pv has room for MAX_PLY moves
+// and depth is below that, so it is filled in place
+void PlayerAI::principal_variation(vector<uint32_t>& pv, uint32_t move, bool max_player, int depth)
+{
+    uint32_t board[3] = { search_board[0], search_board[1], search_board[2] };
+    pv.clear();
+    pv.push_back(move);
+
+    bool is_o = !max_player;
+    simulate_move(board, board, move, is_o, true);
+    for (int ply = 1; ply < depth; ply++)
+    {
+        is_o = !is_o;
+
+        TTEntry entry;
+        if (!table->probe(TranspositionTable::hash(board, is_o), entry) || !entry.move)
+            break;
+
+        MoveList& moves = ply_moves[0];
+        get_all_moves(board, is_o, moves);
+        if (find(moves.begin(), moves.end(), entry.move) == moves.end())
+            break;
+
+        pv.push_back(entry.move);
+        simulate_move(board, board, entry.move, is_o, true);
+    }
+}
+
+void PlayerAI::reserve_lines()
+{
+    lines.resize(multi_pv);
+    found_lines.resize(multi_pv);
+    for (int rank = 0; rank < multi_pv; rank++)
+    {
+        lines[rank].pv.reserve(MAX_PLY);
+        found_lines[rank].pv.reserve(MAX_PLY);
+    }
+    line_count = 0;
+}
+
+// the only line of a single pv search, of minimax and of a book move
+void PlayerAI::set_single_line(uint32_t move, float score)
+{
+    lines[0].move = move;
+    lines[0].score = score;
+    lines[0].pv.clear();
+    lines[0].pv.push_back(move);
+    line_count = 1;
+}
+
+// searches the position after the reply the last search expects, until the opponent moves
+void PlayerAI::start_pondering(bool max_player)
+{
+    stop_pondering();
+
+    TTEntry entry;
+    if (!table->probe(TranspositionTable::hash(this->board, max_player), entry))
+        return;
+
+    MoveList& moves = ply_moves[0];
+    get_all_moves(this->board, max_player, moves);
+    if (!entry.move || find(moves.begin(), moves.end(), entry.move) == moves.end())
+        return;
+
+    simulate_move(this->board, this->board, entry.move, max_player, true);
+    copy(this->board, this->board + 3, ponder_board);
+    ponder_player = max_player;
+
+    cancelled = false;
+    new_search();
+    pondering = true;
+    ponder_thread = thread(&PlayerAI::search, this, max_player);
+}
+
+void PlayerAI::stop_pondering()
+{
+    if (!ponder_thread.joinable())
+        return;
+
+    stopped = true;
+    ponder_thread.join();
+    pondering = false;
+}
+
+// on a ponder hit the running search carries on under the normal limits, counted from when pondering
+// started, so the opponent's thinking time is taken off the time the reply still needs
+bool PlayerAI::ponder_hit(bool max_player, uint32_t o_board, uint32_t x_board, uint32_t kings)
+{
+    if (!ponder_thread.joinable() || max_player != ponder_player ||
+        x_board != ponder_board[0] || o_board != ponder_board[1] || kings != ponder_board[2])
+    {
+        stop_pondering();
+        return false;
+    }
+
+    // the pondering search kept root_move and root_depth up to date itself
+    pondering = false;
+    ponder_thread.join();
+
+    simulate_move(this->board, this->board, root_move, !max_player, true);
+    return true;
+}
+
+void PlayerAI::start_helpers(bool max_player)
 {
-    uint32_t best_move = alphabeta(this->board, depth, max_player, -FLT_MAX, FLT_MAX).move;
-    simulate_move(this->board, this->board, best_move, !max_player, true);
+    for (size_t i = 0; i < helpers.size(); i++)
+    {
+        PlayerAI& helper = *helpers[i];
+        copy(this->board, this->board + 3, helper.board);
+        helper.endgame_db = endgame_db;
+        helper.evaluator = evaluator;
+        helper.stopped = false;
+
+        helper_threads.emplace_back(&PlayerAI::helper_search, &helper, max_player, i + 1);
+    }
 }
 
-ScoreMovePair PlayerAI::alphabeta(uint32_t board[], int depth, bool max_player, float alpha, float beta)
+void PlayerAI::stop_helpers()
+{
+    for (auto& helper : helpers)
+        helper->stopped = true;
+
+    for (thread& helper_thread : helper_threads)
+        helper_thread.join();
+
+    helper_threads.clear();
+}
+
+// helpers fill the shared table ahead of the main search, odd ones skip a depth so they don't all search the same tree
+void PlayerAI::helper_search(bool max_player, int id)
+{
+    clear_ordering();
+    nodes = 0;
+    can_stop = true;
+    root_move = 0;
+
+    set_search_board(max_player);
+
+    for (int depth = 1 + id % 2; depth < MAX_PLY && !stopped; depth++)
+    {
+        ScoreMovePair result = alphabeta(search_board, depth, 0, max_player, -FLT_MAX, FLT_MAX);
+        if (!stopped)
+            root_move = result.move;
+    }
+}
+
+bool PlayerAI::limits_reached()
+{
+    if (pondering)
+        return false;
+
+    if (cancelled)
+        return true;
+
+    if (limits.nodes && nodes >= limits.nodes)
+        return true;
+
+    if (limits.time_ms && (nodes & 1023) == 0)
+    {
+        chrono::duration<double, milli> elapsed = chrono::steady_clock::now() - start_time;
+        return elapsed.count() >= limits.time_ms;
+    }
+
+    return false;
+}
+
+ScoreMovePair PlayerAI::alphabeta(uint32_t board[], int depth, int ply, bool max_player, float alpha, float beta)
 {
     ScoreMovePair result;
 
+    // the first iteration always finishes so there is a move to fall back on
+    nodes++;
+    if (can_stop && (stopped || limits_reached()))
+    {
+        stopped = true;
+        result.move = 0;
+        result.score = 0;
+        return result;
+    }
+
+    // the root still searches so that it has a move to play
+    if (ply > 0 && probe_endgame_db(board, max_player, result.score))
+    {
+        result.move = 0;
+        return result;
+    }
+
+    if (ply == MAX_PLY - 1 || (depth == 0 && !QUIESCENCE))
+    {
+        result.score = evaluate(board, search_eval);
+        return result;
+    }
+
     if (depth == 0)
     {
-        result.score = evaluate(board);
+        result.move = 0;
+        result.score = quiescence(board, ply, max_player, alpha, beta);
         return result;
     }
 
+    const float alpha_orig = alpha, beta_orig = beta;
+    uint32_t hash_move = 0;
+
+    if (ply == 0)
+        hash_move = root_move;
+
+    if (SEARCH_STATS)
+        stats.tt_probes++;
+
+    TTEntry entry;
+    if (table->probe(search_hash, entry))
+    {
+        hash_move = entry.move;
+        if (SEARCH_STATS)
+            stats.tt_hits++;
+
+        // the root always searches so that it has a move to play
+        if (ply > 0 && entry.depth >= depth &&
+            (entry.bound == BOUND_EXACT ||
+             (entry.bound == BOUND_LOWER && entry.score >= beta) ||
+             (entry.bound == BOUND_UPPER && entry.score <= alpha)))
+        {
+            if (SEARCH_STATS)
+                stats.tt_cutoffs++;
+
+            result.move = entry.move;
+            result.score = entry.score;
+            return result;
+        }
+    }
+
     float evalLimit;
-    uint32_t best_move;
+    uint32_t best_move = 0;
+
+    MoveList& moves = ply_moves[ply];
+    get_all_moves(board, !max_player, moves);
+
+    order_moves(board, !max_player, ply, hash_move, moves);
+
+    // this close to the leaves a quiet move can't make up a static score this far outside the window,
+    // a skipped move counts as scoring the margin so the stored bound stays sound
+    bool futile = false, pruned = false;
+    float futility_score = 0;
+    if (selectivity.futility && ply > 0 && depth <= selectivity.futility_depth)
+    {
+        const float margin = selectivity.futility_margin * depth, static_score = evaluate(board, search_eval);
+        futility_score = max_player ? static_score + margin : static_score - margin;
+        futile = max_player ? futility_score <= alpha : futility_score >= beta;
+    }
+    const int reduced_depth = max(depth - 1 - selectivity.lmr_reduction, 0);
 
     if (max_player)
     {
         evalLimit = -FLT_MAX;
-        for (uint32_t move : get_all_moves(board, false))
+        for (int i = 0; i < moves.size(); i++)
         {
-            uint32_t temp_board[3];
-            simulate_move(board, temp_board, move, false, true);
+            uint32_t move = moves.pick(i);
+            const bool quiet = is_quiet(board, move, false);
+
+            if (futile && quiet)
+            {
+                if (SEARCH_STATS)
+                    stats.futility_prunes++;
+                evalLimit = max(evalLimit, futility_score);
+                pruned = true;
+                continue;
+            }
+
+            UndoRecord& undo = undo_stack[ply];
+            make_move(board, move, false, undo);
+
+            // a late quiet move only gets the full depth if a shallower null window search says it beats alpha
+            float evaluation;
+            bool reduced = selectivity.lmr && quiet && i >= selectivity.lmr_moves && depth >= selectivity.lmr_depth;
+            if (reduced)
+            {
+                if (SEARCH_STATS)
+                    stats.reductions++;
+                evaluation = alphabeta(board, reduced_depth, ply + 1, false, alpha, nextafterf(alpha, FLT_MAX)).score;
+                if (evaluation > alpha && !stopped)
+                {
+                    if (SEARCH_STATS)
+                        stats.re_searches++;
+                    reduced = false;
+                }
+            }
+
+            // with pvs only the first move gets the full window, the rest only have to prove they are no better
+            if (!reduced && algorithm == SEARCH_PVS && i > 0)
+            {
+                evaluation = alphabeta(board, depth - 1, ply + 1, false, alpha, nextafterf(alpha, FLT_MAX)).score;
+                if (evaluation > alpha && evaluation < beta && !stopped)
+                    evaluation = alphabeta(board, depth - 1, ply + 1, false, alpha, beta).score;
+            }
+            else if (!reduced)
+                evaluation = alphabeta(board, depth - 1, ply + 1, false, alpha, beta).score;
+
+            unmake_move(board, move, false, undo);
+
+            if (stopped)
+                return result;
 
-            float evaluation = alphabeta(temp_board, depth - 1, false, alpha, beta).score;
             if (evalLimit < evaluation)
                 best_move = move;
 
@@ -109,18 +683,67 @@ ScoreMovePair PlayerAI::alphabeta(uint32_t board[], int depth, bool max_player,
 
             alpha = max(alpha, evalLimit);
             if (beta <= alpha)
+            {
+                if (SEARCH_STATS)
+                {
+                    stats.beta_cutoffs++;
+                    stats.first_move_cutoffs += i == 0;
+                }
+
+                update_ordering(board, false, ply, depth, move);
                 break;
+            }
         }
     }
     else
     {
         evalLimit = FLT_MAX;
-        for (uint32_t move : get_all_moves(board, true))
+        for (int i = 0; i < moves.size(); i++)
         {
-            uint32_t temp_board[3];
-            simulate_move(board, temp_board, move, true, true);
+            uint32_t move = moves.pick(i);
+            const bool quiet = is_quiet(board, move, true);
+
+            if (futile && quiet)
+            {
+                if (SEARCH_STATS)
+                    stats.futility_prunes++;
+                evalLimit = min(evalLimit, futility_score);
+                pruned = true;
+                continue;
+            }
+
+            UndoRecord& undo = undo_stack[ply];
+            make_move(board, move, true, undo);
+
+            float evaluation;
+            bool reduced = selectivity.lmr && quiet && i >= selectivity.lmr_moves && depth >= selectivity.lmr_depth;
+            if (reduced)
+            {
+                if (SEARCH_STATS)
+                    stats.reductions++;
+                evaluation = alphabeta(board, reduced_depth, ply + 1, true, nextafterf(beta, -FLT_MAX), beta).score;
+                if (evaluation < beta && !stopped)
+                {
+                    if (SEARCH_STATS)
+                        stats.re_searches++;
+                    reduced = false;
+                }
+            }
+
+            if (!reduced && algorithm == SEARCH_PVS && i > 0)
+            {
+                evaluation = alphabeta(board, depth - 1, ply + 1, true, nextafterf(beta, -FLT_MAX), beta).score;
+                if (evaluation < beta && evaluation > alpha && !stopped)
+                    evaluation = alphabeta(board, depth - 1, ply + 1, true, alpha, beta).score;
+            }
+            else if (!reduced)
+                evaluation = alphabeta(board, depth - 1, ply + 1, true, alpha, beta).score;
+
+            unmake_move(board, move, true, undo);
+
+            if (stopped)
+                return result;
 
-            float evaluation = alphabeta(temp_board, depth - 1, true, alpha, beta).score;
             if (evalLimit > evaluation)
                 best_move = move;
 
@@ -128,16 +751,155 @@ ScoreMovePair PlayerAI::alphabeta(uint32_t board[], int depth, bool max_player,
 
             beta = min(beta, evalLimit);
             if (beta <= alpha)
+            {
+                if (SEARCH_STATS)
+                {
+                    stats.beta_cutoffs++;
+                    stats.first_move_cutoffs += i == 0;
+                }
+
+                update_ordering(board, true, ply, depth, move);
                 break;
+            }
         }
     }
 
     result.move = best_move;
-    result.score = best_move ? evalLimit : evaluate(board);
+    result.score = (best_move || pruned) ? evalLimit : evaluate(board, search_eval);
+
+    Bound bound = BOUND_EXACT;
+    if (result.score <= alpha_orig)
+        bound = BOUND_UPPER;
+    else if (result.score >= beta_orig)
+        bound = BOUND_LOWER;
+    table->store(search_hash, best_move, result.score, depth, bound);
 
     return result;
 }
 
+// captures are never forced, so the side to move can always stand pat on the static score
+float PlayerAI::quiescence(uint32_t board[], int ply, bool max_player, float alpha, float beta)
+{
+    nodes++;
+    if (SEARCH_STATS)
+        stats.quiescence_nodes++;
+    if (can_stop && (stopped || limits_reached()))
+    {
+        stopped = true;
+        return 0;
+    }
+
+    float stand_pat = evaluate(board, search_eval);
+    if (ply == MAX_PLY - 1)
+        return stand_pat;
+
+    if (max_player)
+    {
+        if (stand_pat >= beta)
+            return stand_pat;
+        alpha = max(alpha, stand_pat);
+    }
+    else
+    {
+        if (stand_pat <= alpha)
+            return stand_pat;
+        beta = min(beta, stand_pat);
+    }
+
+    MoveList& moves = ply_moves[ply];
+    get_all_captures(board, !max_player, moves);
+    order_moves(board, !max_player, ply, 0, moves);
+
+    float best = stand_pat;
+    for (int i = 0; i < moves.size(); i++)
+    {
+        uint32_t move = moves.pick(i);
+
+        UndoRecord& undo = undo_stack[ply];
+        make_move(board, move, !max_player, undo);
+        float evaluation = quiescence(board, ply + 1, !max_player, alpha, beta);
+        unmake_move(board, move, !max_player, undo);
+
+        if (stopped)
+            return 0;
+
+        if (max_player)
+        {
+            best = max(best, evaluation);
+            alpha = max(alpha, best);
+        }
+        else
+        {
+            best = min(best, evaluation);
+            beta = min(beta, best);
+        }
+
+        if (beta <= alpha)
+            break;
+    }
+
+    return best;
+}
+
+// killers only make sense within one search, history carries over at reduced weight
+void PlayerAI::clear_ordering()
+{
+    for (auto& ply_killers : killers)
+        ply_killers[0] = ply_killers[1] = 0;
+
+    for (auto& side : history)
+        for (auto& from_row : side)
+            for (int& to_score : from_row)
+                to_score /= 8;
+}
+
+// hash move, then longer captures, then killers, then the remaining quiet moves by history
+void PlayerAI::order_moves(uint32_t board[], bool is_o, int ply, uint32_t hash_move, MoveList& moves)
+{
+    for (int i = 0; i < moves.size(); i++)
+    {
+        const uint32_t move = moves[i];
+        const uint32_t captures = move & board[!is_o];
+
+        if (move == hash_move)
+            moves.scores[i] = 1 << 30;
+        else if (captures)
+            moves.scores[i] = (1 << 24) + (bitsize(captures) << 16);
+        else if (move == killers[ply][0])
+            moves.scores[i] = (1 << 23) + 1;
+        else if (move == killers[ply][1])
+            moves.scores[i] = 1 << 23;
+        else
+        {
+            const uint32_t from = move & board[is_o], to = move & ~from;
+            moves.scores[i] = history[is_o][__builtin_ctz(from)][__builtin_ctz(to)];
+        }
+    }
+}
+
+// only quiet moves are remembered, captures are already ordered first
+void PlayerAI::update_ordering(uint32_t board[], bool is_o, int ply, int depth, uint32_t move)
+{
+    if (move & board[!is_o])
+        return;
+
+    if (killers[ply][0] != move)
+    {
+        killers[ply][1] = killers[ply][0];
+        killers[ply][0] = move;
+    }
+
+    const uint32_t from = move & board[is_o], to = move & ~from;
+    int& score = history[is_o][__builtin_ctz(from)][__builtin_ctz(to)];
+
+    score += depth * depth;
+    if (score >= 1 << 22)
+        for (auto& side : history)
+            for (auto& from_row : side)
+                for (int& to_score : from_row)
+                    to_score /= 2;
+}
+
 void PlayerAI::update(uint32_t o_board, uint32_t x_board, uint32_t kings, bool o_wins, bool x_wins)
 {
     this->board[0] = x_board;
@@ -148,83 +910,367 @@ void PlayerAI::update(uint32_t o_board, uint32_t x_board, uint32_t kings, bool o
     this->x_wins = x_wins;
 }
 
+// counts the leaves of the move tree, optionally split by root move
+uint64_t PlayerAI::perft(uint32_t o_board, uint32_t x_board, uint32_t kings, bool o_turn, int depth, vector<pair<uint32_t, uint64_t>>* divide)
+{
+    uint32_t board[3] = { x_board, o_board, kings };
+
+    if (divide)
+        divide->clear();
+
+    depth = min(depth, MAX_PLY);
+    if (depth <= 0)
+        return 1;
+
+    MoveList& moves = ply_moves[0];
+    get_all_moves(board, o_turn, moves);
+
+    uint64_t total = 0;
+    for (uint32_t move : moves)
+    {
+        UndoRecord& undo = undo_stack[0];
+        make_move(board, move, o_turn, undo);
+        uint64_t count = perft(board, depth - 1, 1, !o_turn);
+        unmake_move(board, move, o_turn, undo);
+
+        if (divide)
+            divide->push_back(make_pair(move, count));
+
+        total += count;
+    }
+
+    return total;
+}
+
+// the last ply is counted straight from the move list without making the moves
+uint64_t PlayerAI::perft(uint32_t board[], int depth, int ply, bool is_o)
+{
+    if (depth == 0)
+        return 1;
+
+    MoveList& moves = ply_moves[ply];
+    get_all_moves(board, is_o, moves);
+
+    if (depth == 1)
+        return moves.size();
+
+    uint64_t total = 0;
+    for (uint32_t move : moves)
+    {
+        UndoRecord& undo = undo_stack[ply];
+        make_move(board, move, is_o, undo);
+        total += perft(board, depth - 1, ply + 1, !is_o);
+        unmake_move(board, move, is_o, undo);
+    }
+
+    return total;
+}
+
 void PlayerAI::next_move(bool player, uint32_t o_board, uint32_t x_board, uint32_t kings, bool o_wins, bool x_wins)
 {
+    cancelled = false;
+    find_move(player, o_board, x_board, kings, o_wins, x_wins);
+}
+
+// the result is read by the thread that waits on the future, progress is called on the search thread
+future<SearchResult> PlayerAI::start_search(bool player, uint32_t o_board, uint32_t x_board, uint32_t kings, bool o_wins, bool x_wins,
+                                            ProgressCallback progress)
+{
+    join_search();
+    cancelled = false;
+    set_progress(progress);
+
+    promise<SearchResult> result;
+    future<SearchResult> searched = result.get_future();
+    search_thread = thread([=, result = std::move(result)]() mutable
+    {
+        find_move(player, o_board, x_board, kings, o_wins, x_wins);
+        set_progress(nullptr);
+        result.set_value({ root_move, root_score, root_depth, cancelled });
+    });
+
+    return searched;
+}
+
+// a search nobody waits for any more is cancelled, one that has finished only needs its thread joined
+void PlayerAI::join_search()
+{
+    if (!search_thread.joinable())
+        return;
+
+    stop_search();
+    search_thread.join();
+}
+
+void PlayerAI::set_progress(ProgressCallback progress)
+{
+    lock_guard<mutex> guard(progress_lock);
+    this->progress = progress;
+}
+
+void PlayerAI::find_move(bool player, uint32_t o_board, uint32_t x_board, uint32_t kings, bool o_wins, bool x_wins)
+{
+    if (ponder_hit(player, o_board, x_board, kings))
+        return;
+
     update(o_board, x_board, kings, o_wins, x_wins);
 
-    if (USE_ALPHABETA)
-        alphabeta(DEPTH, player);
+    if (probe_opening_book(player))
+        return;
+
+    if (algorithm == SEARCH_MINIMAX)
+        minimax((limits.depth > 0) ? limits.depth : DEPTH, player);
     else
-        minimax(DEPTH, player);
+        iterative_deepening(player);
+}
+
+void PlayerAI::set_hash_size(size_t size_mb)
+{
+    stop_pondering();
+    table->resize(size_mb);
+}
+
+void PlayerAI::set_algorithm(SearchAlgorithm algorithm)
+{
+    stop_pondering();
+    this->algorithm = algorithm;
+
+    for (auto& helper : helpers)
+        helper->algorithm = algorithm;
+}
+
+void PlayerAI::set_selectivity(const Selectivity& selectivity)
+{
+    stop_pondering();
+    this->selectivity = selectivity;
+
+    for (auto& helper : helpers)
+        helper->selectivity = selectivity;
+}
+
+void PlayerAI::set_multi_pv(int count)
+{
+    stop_pondering();
+    multi_pv = max(count, 1);
+    reserve_lines();
+}
+
+void PlayerAI::set_limits(SearchLimits limits)
+{
+    stop_pondering();
+    this->limits = limits;
+}
+
+// engines for many games can map the endgame database and opening book once between them, the weights come along
+void PlayerAI::share_databases(const PlayerAI& other)
+{
+    stop_pondering();
+    endgame_db = other.endgame_db;
+    opening_book = other.opening_book;
+    evaluator = other.evaluator;
+}
+
+bool PlayerAI::load_endgame_db(const string& path)
+{
+    shared_ptr<EndgameDB> database = make_shared<EndgameDB>();
+    if (!database->open(path))
+        return false;
+
+    endgame_db = database;
+    return true;
+}
+
+bool PlayerAI::load_opening_book(const string& path)
+{
+    shared_ptr<OpeningBook> book = make_shared<OpeningBook>();
+    if (!book->open(path))
+        return false;
+
+    opening_book = book;
+    return true;
+}
+
+// plays the stored move without searching, as long as it is legal here
+bool PlayerAI::probe_opening_book(bool max_player)
+{
+    OpeningBook::Entry entry;
+    if (!opening_book || !opening_book->probe(TranspositionTable::hash(this->board, !max_player), entry))
+        return false;
+
+    MoveList& moves = ply_moves[0];
+    get_all_moves(this->board, !max_player, moves);
+    if (find(moves.begin(), moves.end(), entry.move) == moves.end())
+        return false;
+
+    root_move = entry.move;
+    root_score = entry.score;
+    root_depth = 0;
+    set_single_line(root_move, root_score);
+    simulate_move(this->board, this->board, root_move, !max_player, true);
+
+    // nothing was searched
+    if (SEARCH_STATS)
+        stats.clear();
+
+    return true;
+}
+
+// exact scores for positions with few enough pieces, faster wins and slower losses score better
+bool PlayerAI::probe_endgame_db(uint32_t board[], bool max_player, float& score)
+{
+    if (!endgame_db || bitsize(board[0] | board[1]) > endgame_db->max_pieces())
+        return false;
+
+    int distance;
+    switch (endgame_db->probe(board, !max_player, distance))
+    {
+        case EG_WIN:
+            score = EG_WIN_SCORE - distance;
+            break;
+        case EG_LOSS:
+            score = distance - EG_WIN_SCORE;
+            break;
+        case EG_DRAW:
+            score = 0;
+            break;
+        default:
+            return false;
+    }
+
+    if (!max_player)
+        score = -score;
+
+    return true;
+}
+
+void PlayerAI::set_threads(int threads)
+{
+    stop_pondering();
+    helpers.clear();
+    for (int i = 1; i < threads; i++)
+    {
+        helpers.emplace_back(new PlayerAI(table));
+        helpers.back()->algorithm = algorithm;
+        helpers.back()->selectivity = selectivity;
+    }
+
+    helper_threads.reserve(helpers.size());
+}
+
+void PlayerAI::set_weights(const EvalWeights& weights)
+{
+    stop_pondering();
+    evaluator.set_weights(weights);
+}
+
+bool PlayerAI::load_weights(const string& path)
+{
+    EvalWeights weights = evaluator.get_weights();
+    if (!Evaluation::load_weights(path, weights))
+        return false;
+
+    set_weights(weights);
+    return true;
 }
 
 float PlayerAI::evaluate(uint32_t board[])
 {
-    int scores[4];
+    return evaluate(board, evaluator.score(board));
+}
 
-    scores[0] = bitsize(board[0] & (~board[2])); // X pieces
-    scores[1] = bitsize(board[1] & (~board[2])); // O pieces
-    scores[2] = bitsize(board[0] & board[2]);    // X kings
-    scores[3] = bitsize(board[1] & board[2]);    // O kings
+// eval is the table part of the score kept up to date by simulate_move
+float PlayerAI::evaluate(uint32_t board[], int eval)
+{
+    if (SEARCH_STATS)
+        stats.evaluations++;
 
-    return (scores[0] - scores[1]) * 3 + (scores[2] - scores[3]) * 5;
+    return (eval + evaluator.mobility(board)) / 100.0f;
 }
 
-unordered_map<uint32_t, uint32_t> PlayerAI::get_piece_moves(uint32_t board[], uint32_t pos, uint32_t origin, uint32_t captures)
+// no capture and no man reaching the far row
+bool PlayerAI::is_quiet(uint32_t board[], uint32_t move, bool is_o)
 {
-    unordered_map<uint32_t, uint32_t> moves;
+    if (move & board[!is_o])
+        return false;
 
-    const uint32_t x_board = board[0], o_board = board[1], kings = board[2];
-    bool o_turn = pos & o_board;
+    const uint32_t from = move & board[is_o], to = move & ~from;
+    return (from & board[2]) || !(to & (is_o ? X_BACK_RANK : O_BACK_RANK));
+}
+
+// moves of this piece are listed from index first onwards, only the longest capture between two squares is kept.
+// chains are followed depth first with an explicit stack, in the same order the directions are tried below
+void PlayerAI::get_piece_moves(uint32_t board[], uint32_t origin, bool quiet, MoveList& moves, int first)
+{
+    struct Hop {
+        uint32_t pos;
+        uint32_t captures;
+        int dir;
+    };
+
+    const bool o_turn = origin & board[1];
     const uint32_t player = board[o_turn], opponent = board[!o_turn];
 
-    if (captures)
-        moves[pos | origin] = captures;
+    // forward left, forward right, then backward left and right for kings
+    const int flip = o_turn ? 0 : 2;
+    const int dir_count = (origin & board[2]) ? 4 : 2;
 
-    bool forward = true, left = true;
-    do
-    {
-        uint32_t new_pos = move(pos, left, forward, o_turn);
+    // the piece has left its square and captured pieces are taken off as it goes
+    const uint32_t others = player & ~origin;
 
-        if (new_pos)
+    // the stack holds the current chain only, the piece and then one entry per capture. Branches don't add entries,
+    // each entry tries its directions in turn and a branch replaces the one before it. Every hop takes a different
+    // opponent piece and a side has at most 12, so the chain is at most 12 hops and 13 entries deep
+    Hop stack[1 + 12];
+    int top = 0;
+    stack[0] = { origin, 0, 0 };
+
+    while (top >= 0)
+    {
+        Hop& hop = stack[top];
+        if (hop.dir == dir_count)
         {
-            if (!captures && !(new_pos & (o_board | x_board)))
-                moves[pos | new_pos] = 0;
-            else
-            {
-                uint32_t capture_pos = new_pos;
-                uint32_t new_pos = move(capture_pos, left, forward, o_turn);
+            top--;
+            continue;
+        }
 
-                if (new_pos && !(captures & capture_pos) && (capture_pos & opponent) &&
-                    ((new_pos & origin) || !(new_pos & (o_board | x_board))))
-                {
-                    uint32_t new_board[3];
-                    simulate_move(board, new_board, pos | new_pos | capture_pos, o_turn, false);
-
-                    for (const auto& cur_pos : get_piece_moves(new_board, new_pos, origin, captures | capture_pos))
-                    {
-                        auto prev_move = moves.find(cur_pos.first);
-                        if (prev_move == moves.end())
-                            moves.insert(cur_pos);
-                        else if (bitsize(prev_move->second) < bitsize(cur_pos.second))
-                            prev_move->second = cur_pos.second;
-                    }
-                }
-            }
+        const int square = __builtin_ctz(hop.pos), dir = hop.dir++ ^ flip;
+        const uint32_t neighbour = SQUARES.neighbour[square][dir], landing = SQUARES.jump[square][dir];
+        const uint32_t remaining = opponent & ~hop.captures;
+
+        if (quiet && top == 0 && neighbour && !(neighbour & (player | opponent)))
+        {
+            moves.push_back(origin | neighbour);
+            continue;
         }
 
-        left = !left;
-        if (left && (kings & pos))
-            forward = !forward;
+        if (!landing || !(neighbour & remaining) || (landing & (others | remaining)))
+            continue;
+
+        // captured squares are never landing squares, so masking out the opponent recovers a listed move's squares
+        const uint32_t captures = hop.captures | neighbour, squares = landing | origin;
 
-    } while (!left || !forward);
+        int i = first;
+        while (i < moves.size() && (moves[i] & ~opponent) != squares)
+            i++;
 
-    return moves;
+        if (i == moves.size())
+            moves.push_back(squares | captures);
+        else if (bitsize(moves[i] & opponent) < bitsize(captures))
+            moves[i] = squares | captures;
+
+        assert(top + 1 < (int)(sizeof(stack) / sizeof(stack[0])));
+        stack[++top] = { landing, captures, 0 };
+    }
+}
+
+void PlayerAI::get_piece_moves(uint32_t board[], uint32_t pos, MoveList& moves)
+{
+    get_piece_moves(board, pos, true, moves, moves.size());
 }
 
-unordered_map<uint32_t, uint32_t> PlayerAI::get_piece_moves(uint32_t board[], uint32_t pos)
+void PlayerAI::get_piece_captures(uint32_t board[], uint32_t pos, MoveList& moves)
 {
-    return get_piece_moves(board, pos, pos, 0);
+    get_piece_moves(board, pos, false, moves, moves.size());
 }
 
 void PlayerAI::simulate_move(uint32_t board[], uint32_t new_board[], uint32_t move, bool is_o, bool promote)
@@ -246,47 +1292,141 @@ void PlayerAI::simulate_move(uint32_t board[], uint32_t new_board[], uint32_t mo
         new_board[2] |= (new_board[0] & O_BACK_RANK) | (new_board[1] & X_BACK_RANK);
 }
 
-vector<uint32_t> PlayerAI::get_all_moves(uint32_t board[], bool is_o)
+// the search works on one board, the root position is copied in once with its hash and table evaluation
+void PlayerAI::set_search_board(bool max_player)
 {
-    vector<uint32_t> moves;
+    copy(this->board, this->board + 3, search_board);
+    search_hash = TranspositionTable::hash(search_board, !max_player);
+    search_eval = evaluator.score(search_board);
+}
+
+// plays a move on the board in place and keeps the hash and table evaluation up to date square by square,
+// only the squares that changed are hashed, and the side to move always flips
+void PlayerAI::make_move(uint32_t board[], uint32_t move, bool is_o, UndoRecord& undo)
+{
+    const uint32_t captures = move & board[!is_o], from = move & board[is_o], to = move & ~captures & ~from;
+
+    undo.captures = captures;
+    undo.captured_kings = captures & board[2];
+    undo.hash = search_hash;
+    undo.eval = search_eval;
+    undo.promoted = false;
+
+    for (uint32_t pieces = captures; pieces; pieces &= pieces - 1)
+    {
+        const int square = __builtin_ctz(pieces), piece = !is_o + ((board[2] & (pieces & -pieces)) ? 2 : 0);
+        search_hash ^= TranspositionTable::piece_key(piece, square);
+        search_eval -= evaluator.square_score(piece, square);
+    }
 
-    for (uint32_t pos = 1; pos > 0; pos <<= 1)
-        if (board[is_o] & pos)
-            for (const auto& move_pair : get_piece_moves(board, pos))
-                moves.push_back((move_pair.first) | (move_pair.second));
+    board[!is_o] &= ~captures;
+    board[2] &= ~captures;
 
-    return moves;
+    // a capture chain can end on the square it started from
+    if (to)
+    {
+        const int piece = is_o + ((board[2] & from) ? 2 : 0);
+
+        board[is_o] ^= from | to;
+        if (board[2] & from)
+            board[2] ^= from | to;
+        else if (to & (is_o ? X_BACK_RANK : O_BACK_RANK))
+        {
+            board[2] |= to;
+            undo.promoted = true;
+        }
+
+        const int new_piece = piece + (undo.promoted ? 2 : 0);
+        const int from_square = __builtin_ctz(from), to_square = __builtin_ctz(to);
+        search_hash ^= TranspositionTable::piece_key(piece, from_square) ^ TranspositionTable::piece_key(new_piece, to_square);
+        search_eval += evaluator.square_score(new_piece, to_square) - evaluator.square_score(piece, from_square);
+    }
+
+    search_hash ^= TranspositionTable::side_key();
 }
 
-// return 0 if move is out of bounds
-uint32_t PlayerAI::move(uint32_t pos, bool left, bool forward, bool o_turn)
+void PlayerAI::unmake_move(uint32_t board[], uint32_t move, bool is_o, const UndoRecord& undo)
 {
-    bool shift_left = o_turn == forward;
-    int shift_value = 5;
+    const uint32_t squares = move & ~undo.captures, from = squares & ~board[is_o], to = squares & board[is_o];
 
-    if (pos & EVEN_MASK)
-        shift_value--;
-    if (left)
-        shift_value--;
-    if (!shift_left)
-        shift_value = 8 - shift_value;
+    // nothing moved if the chain ended where it started
+    if (from)
+    {
+        if (undo.promoted)
+            board[2] &= ~to;
+        else if (board[2] & to)
+            board[2] ^= from | to;
+        board[is_o] ^= from | to;
+    }
 
-    if ((left && (pos & L_COL_MASK)) || (!left && (pos & R_COL_MASK)))
-        return 0;
+    board[!is_o] |= undo.captures;
+    board[2] |= undo.captured_kings;
 
-    if (shift_left)
-        pos <<= shift_value;
-    else
-        pos >>= shift_value;
+    search_hash = undo.hash;
+    search_eval = undo.eval;
+}
+
+// capture chains only, the moves the quiescence search looks at
+void PlayerAI::get_all_captures(uint32_t board[], bool is_o, MoveList& moves)
+{
+    moves.clear();
+
+    const uint32_t player = board[is_o], opponent = board[!is_o];
+    const uint32_t empty = ~(board[0] | board[1]);
+    uint32_t jumpers = 0;
+
+    // jump origins of every piece at once, one direction at a time
+    for (int dir = 0; dir < 4; dir++)
+    {
+        bool left = !(dir & 1), up = is_o == !(dir & 2);
+        uint32_t movers = (dir & 2) ? player & board[2] : player;
+
+        uint32_t landings = shift(shift(movers, left, up) & opponent, left, up) & empty;
+        jumpers |= shift(shift(landings, !left, !up), !left, !up);
+    }
+
+    // only capture chains need to be expanded piece by piece
+    while (jumpers)
+    {
+        uint32_t pos = jumpers & -jumpers;
+        jumpers ^= pos;
 
-    return pos;
+        get_piece_captures(board, pos, moves);
+    }
 }
 
-int PlayerAI::bitsize(uint32_t num)
+// captures are listed first
+void PlayerAI::get_all_moves(uint32_t board[], bool is_o, MoveList& moves)
 {
-    int count = num & 1;
-    while(num >>= 1)
-        count += num & 1;
+    get_all_captures(board, is_o, moves);
+
+    const uint32_t player = board[is_o];
+    const uint32_t empty = ~(board[0] | board[1]);
 
-    return count;
+    // quiet targets of every piece at once, one direction at a time
+    for (int dir = 0; dir < 4; dir++)
+    {
+        bool left = !(dir & 1), up = is_o == !(dir & 2);
+        uint32_t movers = (dir & 2) ? player & board[2] : player;
+
+        uint32_t targets = shift(movers, left, up) & empty;
+        while (targets)
+        {
+            uint32_t new_pos = targets & -targets;
+            targets ^= new_pos;
+            moves.push_back(shift(new_pos, !left, !up) | new_pos);
+        }
+    }
+}
+
+// return 0 if move is out of bounds
+uint32_t PlayerAI::move(uint32_t pos, bool left, bool forward, bool o_turn)
+{
+    const bool up = o_turn == forward;
+    return SQUARES.neighbour[__builtin_ctz(pos)][(up ? 0 : 2) + (left ? 0 : 1)];
+}
+
+int PlayerAI::bitsize(uint32_t num)
+{
+    return __builtin_popcount(num);
 }
@@ -0,0 +1,56 @@
+#include "SearchStats.h"
+#include <sstream>
+
+using namespace std;
+
+// the iterations keep their capacity, so a search doesn't allocate once the first one has reserved it
+void SearchStats::clear()
+{
+    vector<IterationStats> kept;
+    kept.swap(iterations);
+    kept.clear();
+
+    *this = SearchStats();
+    iterations.swap(kept);
+}
+
+double SearchStats::nps() const
+{
+    return time_ms > 0 ? nodes * 1000.0 / time_ms : 0;
+}
+
+double SearchStats::first_move_cutoff_rate() const
+{
+    return beta_cutoffs ? (double)first_move_cutoffs / beta_cutoffs : 0;
+}
+
+string SearchStats::to_json() const
+{
+    ostringstream json;
+
+    json << "{\"nodes\":" << nodes
+         << ",\"quiescence_nodes\":" << quiescence_nodes
+         << ",\"evaluations\":" << evaluations
+         << ",\"beta_cutoffs\":" << beta_cutoffs
+         << ",\"first_move_cutoff_rate\":" << first_move_cutoff_rate()
+         << ",\"tt_probes\":" << tt_probes
+         << ",\"tt_hits\":" << tt_hits
+         << ",\"tt_cutoffs\":" << tt_cutoffs
+         << ",\"reductions\":" << reductions
+         << ",\"re_searches\":" << re_searches
+         << ",\"futility_prunes\":" << futility_prunes
+         << ",\"time_ms\":" << time_ms
+         << ",\"nps\":" << (uint64_t)nps()
+         << ",\"iterations\":[";
+
+    for (size_t i = 0; i < iterations.size(); i++)
+    {
+        const IterationStats& iteration = iterations[i];
+        json << (i ? "," : "") << "{\"depth\":" << iteration.depth << ",\"nodes\":" << iteration.nodes
+             << ",\"time_ms\":" << iteration.time_ms << ",\"score\":" << iteration.score
+             << ",\"move\":" << iteration.move << "}";
+    }
+
+    json << "]}";
+    return json.str();
+}
@@ -0,0 +1,165 @@
+#include "TrainingData.h"
+#include "TranspositionTable.h"
+#include <cstring>
+
+// records collected in memory before one large write
+#define WRITE_BUFFER_RECORDS (1 << 16)
+
+using namespace std;
+
+const char TrainingData::MAGIC[8] = { 'C', 'K', 'T', 'R', 'A', 'I', 'N', '1' };
+
+TrainingWriter::TrainingWriter()
+{
+}
+
+TrainingWriter::~TrainingWriter()
+{
+    close();
+}
+
+bool TrainingWriter::open(const string& path)
+{
+    close();
+
+    file = fopen(path.c_str(), "wb");
+    if (!file)
+        return false;
+
+    // the count is filled in by close
+    TrainingData::Header header = {};
+    memcpy(header.magic, TrainingData::MAGIC, sizeof(header.magic));
+    error = fwrite(&header, sizeof(header), 1, file) != 1;
+
+    buffer.reserve(WRITE_BUFFER_RECORDS);
+    seen.assign(1 << 20, 0);
+    seen_count = count = skipped = 0;
+
+    return !error;
+}
+
+bool TrainingWriter::close()
+{
+    if (!file)
+        return !error;
+
+    flush();
+
+    TrainingData::Header header = {};
+    memcpy(header.magic, TrainingData::MAGIC, sizeof(header.magic));
+    header.count = count;
+    if (fseek(file, 0, SEEK_SET) != 0 || fwrite(&header, sizeof(header), 1, file) != 1)
+        error = true;
+
+    if (fclose(file) != 0)
+        error = true;
+    file = nullptr;
+    seen.clear();
+    seen.shrink_to_fit();
+
+    return !error;
+}
+
+void TrainingWriter::write_game(vector<TrainingRecord>& positions, int result)
+{
+    for (TrainingRecord& record : positions)
+    {
+        if (!insert(TranspositionTable::hash(record.board, record.is_o)))
+        {
+            skipped++;
+            continue;
+        }
+
+        record.result = result;
+        record.reserved = 0;
+        buffer.push_back(record);
+
+        if (buffer.size() == WRITE_BUFFER_RECORDS)
+            flush();
+    }
+}
+
+// false if the key was already in the set, the set doubles when it is half full
+bool TrainingWriter::insert(uint64_t key)
+{
+    if (!key)
+        key = 1;
+
+    if (2 * (seen_count + 1) > seen.size())
+    {
+        vector<uint64_t> old(seen.size() * 2, 0);
+        old.swap(seen);
+        seen_count = 0;
+        for (uint64_t old_key : old)
+            if (old_key)
+                insert(old_key);
+    }
+
+    size_t mask = seen.size() - 1;
+    for (size_t i = key & mask; ; i = (i + 1) & mask)
+    {
+        if (seen[i] == key)
+            return false;
+        if (!seen[i])
+        {
+            seen[i] = key;
+            seen_count++;
+            return true;
+        }
+    }
+}
+
+// only whole records that were written are counted, so a short write leaves a header that matches the file
+bool TrainingWriter::flush()
+{
+    if (!error && !buffer.empty())
+    {
+        // stdio buffers part of the write, so it has to reach the file before the records are counted
+        size_t records = fwrite(buffer.data(), sizeof(TrainingRecord), buffer.size(), file);
+        if (fflush(file) != 0)
+            records = 0;
+        count += records;
+        error = records != buffer.size();
+    }
+
+    buffer.clear();
+    return !error;
+}
+
+TrainingData::TrainingData()
+{
+}
+
+TrainingData::~TrainingData()
+{
+}
+
+bool TrainingData::open(const string& path)
+{
+    close();
+
+    if (!file.open(path) || file.size() < sizeof(Header))
+        return false;
+
+    // the count is checked by division, a corrupt count times the record size could wrap around
+    Header header;
+    memcpy(&header, file.data(), sizeof(Header));
+    if (memcmp(header.magic, MAGIC, sizeof(MAGIC)) != 0 || header.count > (file.size() - sizeof(Header)) / sizeof(TrainingRecord))
+    {
+        close();
+        return false;
+    }
+
+    // the header keeps the records 4 byte aligned within the page aligned mapping
+    records = (const TrainingRecord*)(file.data() + sizeof(Header));
+    count = header.count;
+
+    return true;
+}
+
+void TrainingData::close()
+{
+    file.close();
+    records = nullptr;
+    count = 0;
+}
@@ -0,0 +1,168 @@
+#include "TranspositionTable.h"
+#include <cstring>
+
+using namespace std;
+
+namespace
+{
+    // x men, o men, x kings and o kings on every square, then the side to move
+    struct ZobristKeys {
+        uint64_t pieces[4][32];
+        uint64_t o_turn;
+    };
+
+    constexpr uint64_t splitmix64(uint64_t& state)
+    {
+        uint64_t z = (state += 0x9E3779B97F4A7C15);
+        z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9;
+        z = (z ^ (z >> 27)) * 0x94D049BB133111EB;
+        return z ^ (z >> 31);
+    }
+
+    // fixed seed so hashes stay the same between runs
+    constexpr ZobristKeys make_keys()
+    {
+        ZobristKeys keys = {};
+        uint64_t state = 20220506;
+
+        for (int piece = 0; piece < 4; piece++)
+            for (int square = 0; square < 32; square++)
+                keys.pieces[piece][square] = splitmix64(state);
+        keys.o_turn = splitmix64(state);
+
+        return keys;
+    }
+
+    constexpr ZobristKeys ZOBRIST = make_keys();
+
+    uint64_t hash_pieces(int piece, uint32_t pieces)
+    {
+        uint64_t hash = 0;
+        for (; pieces; pieces &= pieces - 1)
+            hash ^= ZOBRIST.pieces[piece][__builtin_ctz(pieces)];
+
+        return hash;
+    }
+}
+
+TranspositionTable::TranspositionTable(size_t size_mb)
+{
+    resize(size_mb);
+}
+
+TranspositionTable::~TranspositionTable()
+{
+}
+
+// the number of clusters is rounded down to a power of two so the key can index it directly
+void TranspositionTable::resize(size_t size_mb)
+{
+    size_t count = 1;
+    while (count * 2 * sizeof(Cluster) <= size_mb * 1024 * 1024)
+        count *= 2;
+
+    clusters.reset(new Cluster[count]());
+    cluster_count = count;
+    generation.store(0, memory_order_relaxed);
+}
+
+void TranspositionTable::clear()
+{
+    for (size_t i = 0; i < cluster_count; i++)
+        for (auto& entry : clusters[i].data)
+        {
+            entry[0].store(0, memory_order_relaxed);
+            entry[1].store(0, memory_order_relaxed);
+        }
+
+    generation.store(0, memory_order_relaxed);
+}
+
+void TranspositionTable::new_search()
+{
+    generation.store((generation.load(memory_order_relaxed) + 1) & 63, memory_order_relaxed);
+}
+
+bool TranspositionTable::probe(uint64_t key, TTEntry& entry)
+{
+    Cluster& cluster = clusters[key & (cluster_count - 1)];
+
+    for (int i = 0; i < CLUSTER_SIZE; i++)
+    {
+        const uint64_t data = cluster.data[i][1].load(memory_order_relaxed);
+        const uint64_t info = cluster.data[i][0].load(memory_order_relaxed) ^ data;
+        if (!info || (info & KEY_MASK) != (key & KEY_MASK))
+            continue;
+
+        uint32_t score_bits = data >> 32;
+        entry.move = (uint32_t)data;
+        memcpy(&entry.score, &score_bits, sizeof(float));
+        entry.depth = (info >> 8) & 255;
+        entry.bound = (Bound)((info >> 6) & 3);
+
+        return true;
+    }
+
+    return false;
+}
+
+// replace the same position, an empty slot, or else the shallowest entry where older searches count as shallower
+void TranspositionTable::store(uint64_t key, uint32_t move, float score, int depth, Bound bound)
+{
+    Cluster& cluster = clusters[key & (cluster_count - 1)];
+    const uint8_t generation = this->generation.load(memory_order_relaxed);
+
+    int replace = 0, replace_value = 0;
+    for (int i = 0; i < CLUSTER_SIZE; i++)
+    {
+        const uint64_t data = cluster.data[i][1].load(memory_order_relaxed);
+        const uint64_t info = cluster.data[i][0].load(memory_order_relaxed) ^ data;
+        if (!info || (info & KEY_MASK) == (key & KEY_MASK))
+        {
+            replace = i;
+            if (info && !move)
+                move = (uint32_t)data;
+            break;
+        }
+
+        const int age = (generation - (info & 63)) & 63;
+        const int value = (int)((info >> 8) & 255) - 8 * age;
+        if (i == 0 || value < replace_value)
+        {
+            replace = i;
+            replace_value = value;
+        }
+    }
+
+    uint32_t score_bits;
+    memcpy(&score_bits, &score, sizeof(float));
+
+    // the bound is never BOUND_NONE, which keeps a stored info word from being zero
+    const uint64_t info = (key & KEY_MASK) | ((uint64_t)(depth & 255) << 8) | ((uint64_t)bound << 6) | generation;
+    const uint64_t data = ((uint64_t)score_bits << 32) | move;
+
+    cluster.data[replace][0].store(info ^ data, memory_order_relaxed);
+    cluster.data[replace][1].store(data, memory_order_relaxed);
+}
+
+uint64_t TranspositionTable::hash(const uint32_t board[], bool is_o)
+{
+    uint64_t hash = is_o ? ZOBRIST.o_turn : 0;
+
+    hash ^= hash_pieces(0, board[0] & ~board[2]);
+    hash ^= hash_pieces(1, board[1] & ~board[2]);
+    hash ^= hash_pieces(2, board[0] & board[2]);
+    hash ^= hash_pieces(3, board[1] & board[2]);
+
+    return hash;
+}
+
+uint64_t TranspositionTable::piece_key(int piece, int square)
+{
+    return ZOBRIST.pieces[piece][square];
+}
+
+uint64_t TranspositionTable::side_key()
+{
+    return ZOBRIST.o_turn;
+}
@@ -0,0 +1,322 @@
+#include <iostream>
+#include <iomanip>
+#include <chrono>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+#include <functional>
+#include "PlayerAI.h"
+
+using namespace std;
+
+struct BenchPosition {
+    uint32_t x_board, o_board, kings;
+    bool o_turn;
+};
+
+// opening, two middle games and a kings ending taken from engine games
+const BenchPosition SEARCH_POSITIONS[] = {
+    { 4293918720, 4095, 0, true },
+    { 1910179840, 42931, 0, true },
+    { 435224832, 320019, 0, true },
+    { 29430028, 570458131, 570425356, true },
+};
+
+// middle games and endings from engine self-play, o and x to move, for timing the primitives
+const BenchPosition PRIMITIVE_POSITIONS[] = {
+    { 4273274880, 28095, 0, true },
+    { 2851536896, 53109, 0, true },
+    { 2329092224, 38768, 0, true },
+    { 2715947008, 304481, 0, true },
+    { 2281899008, 34373904, 33555456, true },
+    { 2148732960, 2416897, 2097184, true },
+    { 1078394904, 33587328, 33554456, true },
+    { 2147485250, 876740865, 809633346, true },
+    { 4271046656, 4214687, 0, false },
+    { 4257546240, 180479, 0, false },
+    { 2281899008, 42238224, 33555456, false },
+    { 2164463616, 33596705, 33554432, false },
+    { 18944, 811859968, 811616768, false },
+    { 2147488834, 606216449, 604111938, false },
+    { 1088, 4588032, 4589120, false },
+    { 2147500548, 36045057, 36061700, false },
+};
+
+// PlayerAI lets this class call its private primitives
+class PrimitiveBenchmark
+{
+    public:
+        static void run(int min_ms);
+
+    private:
+        // results are summed into here so the calls can't be optimised away
+        static volatile uint64_t sink;
+
+        static void time_primitive(const string& name, uint64_t ops_per_pass, int min_ms, const function<uint64_t()>& pass);
+};
+
+volatile uint64_t PrimitiveBenchmark::sink = 0;
+
+// repeats a pass over the corpus until at least min_ms have gone by
+void PrimitiveBenchmark::time_primitive(const string& name, uint64_t ops_per_pass, int min_ms, const function<uint64_t()>& pass)
+{
+    uint64_t passes = 0, total = 0;
+    double elapsed_ms = 0;
+
+    auto start = chrono::steady_clock::now();
+    do
+    {
+        for (int i = 0; i < 64; i++)
+            total += pass();
+        passes += 64;
+        elapsed_ms = chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+    } while (elapsed_ms < min_ms);
+    sink = sink + total;
+
+    const double ops = (double)passes * ops_per_pass;
+    cout << left << setw(20) << name << right << setw(12) << fixed << setprecision(2) << elapsed_ms * 1e6 / ops
+         << setw(16) << setprecision(0) << ops * 1000 / elapsed_ms << endl;
+}
+
+void PrimitiveBenchmark::run(int min_ms)
+{
+    struct PositionData {
+        uint32_t board[3];
+        bool is_o;
+        vector<uint32_t> pieces;
+        MoveList moves;
+        int eval;
+    };
+
+    PlayerAI playerAI(0, 0, 0);
+    vector<PositionData> corpus;
+    uint64_t piece_count = 0, move_count = 0;
+
+    for (const BenchPosition& pos : PRIMITIVE_POSITIONS)
+    {
+        PositionData data = { { pos.x_board, pos.o_board, pos.kings }, pos.o_turn, {}, {}, 0 };
+        for (uint32_t pieces = data.board[data.is_o]; pieces; pieces &= pieces - 1)
+            data.pieces.push_back(pieces & -pieces);
+
+        playerAI.get_all_moves(data.board, data.is_o, data.moves);
+        data.eval = playerAI.evaluator.score(data.board);
+
+        piece_count += data.pieces.size();
+        move_count += data.moves.size();
+        corpus.push_back(data);
+    }
+
+    cout << corpus.size() << " positions, " << piece_count << " pieces to move, " << move_count << " moves\n\n";
+    cout << "primitive                 ns/op          ops/sec\n";
+
+    time_primitive("move", piece_count * 4, min_ms, [&]()
+    {
+        uint64_t total = 0;
+        for (PositionData& data : corpus)
+            for (uint32_t pos : data.pieces)
+                for (int dir = 0; dir < 4; dir++)
+                    total += playerAI.move(pos, dir & 1, dir & 2, data.is_o);
+        return total;
+    });
+
+    time_primitive("simulate_move", move_count, min_ms, [&]()
+    {
+        uint64_t total = 0;
+        for (PositionData& data : corpus)
+            for (uint32_t move : data.moves)
+            {
+                uint32_t new_board[3];
+                playerAI.simulate_move(data.board, new_board, move, data.is_o, true);
+                total += new_board[0] ^ new_board[1] ^ new_board[2];
+            }
+        return total;
+    });
+
+    time_primitive("get_piece_moves", piece_count, min_ms, [&]()
+    {
+        uint64_t total = 0;
+        MoveList moves;
+        for (PositionData& data : corpus)
+            for (uint32_t pos : data.pieces)
+            {
+                moves.clear();
+                playerAI.get_piece_moves(data.board, pos, moves);
+                total += moves.size();
+            }
+        return total;
+    });
+
+    time_primitive("get_all_moves", corpus.size(), min_ms, [&]()
+    {
+        uint64_t total = 0;
+        MoveList moves;
+        for (PositionData& data : corpus)
+        {
+            playerAI.get_all_moves(data.board, data.is_o, moves);
+            total += moves.size();
+        }
+        return total;
+    });
+
+    time_primitive("evaluate (full)", corpus.size(), min_ms, [&]()
+    {
+        float total = 0;
+        for (PositionData& data : corpus)
+            total += playerAI.evaluate(data.board);
+        return (uint64_t)total;
+    });
+
+    time_primitive("evaluate (leaf)", corpus.size(), min_ms, [&]()
+    {
+        float total = 0;
+        for (PositionData& data : corpus)
+            total += playerAI.evaluate(data.board, data.eval);
+        return (uint64_t)total;
+    });
+
+    time_primitive("bitsize", corpus.size() * 3, min_ms, [&]()
+    {
+        uint64_t total = 0;
+        for (PositionData& data : corpus)
+            for (int i = 0; i < 3; i++)
+                total += playerAI.bitsize(data.board[i]);
+        return total;
+    });
+}
+
+// time to reach a fixed depth on every position, each with a fresh table, for 1 to max_threads threads
+void smp_benchmark(int max_threads, int depth)
+{
+    cout << "time to depth " << depth << " over " << size(SEARCH_POSITIONS) << " positions\n\n";
+    cout << "threads     time_ms   speedup\n";
+
+    double single_ms = 0;
+    for (int threads = 1; threads <= max_threads; threads++)
+    {
+        double total_ms = 0;
+        for (const BenchPosition& pos : SEARCH_POSITIONS)
+        {
+            unique_ptr<PlayerAI> playerAI(new PlayerAI(pos.o_board, pos.x_board, pos.kings));
+            playerAI->set_threads(threads);
+            playerAI->set_limits({ depth, 0, 0 });
+
+            auto start = chrono::steady_clock::now();
+            playerAI->next_move(!pos.o_turn, pos.o_board, pos.x_board, pos.kings, false, false);
+            total_ms += chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+        }
+
+        if (threads == 1)
+            single_ms = total_ms;
+
+        cout << setw(7) << threads << setw(12) << fixed << setprecision(1) << total_ms
+             << setw(10) << setprecision(2) << single_ms / total_ms << endl;
+    }
+}
+
+// one json line of search statistics per position, for comparing builds, algorithms or logging over time
+void stats_benchmark(int depth, SearchAlgorithm algorithm, const string& selective)
+{
+    for (const BenchPosition& pos : SEARCH_POSITIONS)
+    {
+        unique_ptr<PlayerAI> playerAI(new PlayerAI(pos.o_board, pos.x_board, pos.kings));
+        playerAI->set_algorithm(algorithm);
+        if (selective != "all")
+        {
+            Selectivity selectivity = playerAI->get_selectivity();
+            selectivity.lmr = selective == "lmr";
+            selectivity.futility = selective == "futility";
+            playerAI->set_selectivity(selectivity);
+        }
+        playerAI->set_limits({ depth, 0, 0 });
+        playerAI->next_move(!pos.o_turn, pos.o_board, pos.x_board, pos.kings, false, false);
+
+        cout << playerAI->last_stats().to_json() << endl;
+    }
+}
+
+// nodes over all positions for every multi-pv count up to max_count, each search starting from an empty table
+void multi_pv_benchmark(int depth, int max_count)
+{
+    cout << "  lines       nodes     ratio" << endl;
+
+    uint64_t single_nodes = 0;
+    for (int count = 1; count <= max_count; count++)
+    {
+        uint64_t total_nodes = 0;
+        for (const BenchPosition& pos : SEARCH_POSITIONS)
+        {
+            unique_ptr<PlayerAI> playerAI(new PlayerAI(pos.o_board, pos.x_board, pos.kings));
+            playerAI->set_multi_pv(count);
+            playerAI->set_limits({ depth, 0, 0 });
+            playerAI->next_move(!pos.o_turn, pos.o_board, pos.x_board, pos.kings, false, false);
+            total_nodes += playerAI->last_stats().nodes;
+        }
+
+        if (count == 1)
+            single_nodes = total_nodes;
+
+        cout << setw(7) << count << setw(12) << total_nodes << setw(10) << fixed << setprecision(2)
+             << (double)total_nodes / single_nodes << endl;
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    string mode = (argc > 1) ? argv[1] : "smp";
+
+    if (mode == "smp")
+    {
+        int threads = (argc > 2) ? stoi(argv[2]) : max(1u, thread::hardware_concurrency());
+        int depth = (argc > 3) ? stoi(argv[3]) : 13;
+        smp_benchmark(threads, depth);
+    }
+    else if (mode == "stats")
+    {
+        int depth = (argc > 2) ? stoi(argv[2]) : 13;
+        string name = (argc > 3) ? argv[3] : "pvs";
+        string selective = (argc > 4) ? argv[4] : "all";
+
+        SearchAlgorithm algorithm;
+        if (name == "minimax")
+            algorithm = SEARCH_MINIMAX;
+        else if (name == "alphabeta")
+            algorithm = SEARCH_ALPHABETA;
+        else if (name == "pvs")
+            algorithm = SEARCH_PVS;
+        else
+        {
+            cout << "unknown algorithm " << name << ", expected minimax, alphabeta or pvs\n";
+            return 1;
+        }
+
+        if (selective != "all" && selective != "lmr" && selective != "futility" && selective != "none")
+        {
+            cout << "unknown pruning " << selective << ", expected all, lmr, futility or none\n";
+            return 1;
+        }
+
+        stats_benchmark(depth, algorithm, selective);
+    }
+    else if (mode == "multipv")
+    {
+        int depth = (argc > 2) ? stoi(argv[2]) : 13;
+        int max_count = (argc > 3) ? stoi(argv[3]) : 4;
+        multi_pv_benchmark(depth, max_count);
+    }
+    else if (mode == "primitives")
+    {
+        int min_ms = (argc > 2) ? stoi(argv[2]) : 500;
+        PrimitiveBenchmark::run(min_ms);
+    }
+    else
+    {
+        cout << "usage: " << argv[0] << " smp [max threads] [depth]\n";
+        cout << "       " << argv[0] << " stats [depth] [minimax|alphabeta|pvs] [all|lmr|futility|none]\n";
+        cout << "       " << argv[0] << " multipv [depth] [max lines]\n";
+        cout << "       " << argv[0] << " primitives [ms per primitive]\n";
+        return 1;
+    }
+
+    return 0;
+}
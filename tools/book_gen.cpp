@@ -0,0 +1,118 @@
+#include <iostream>
+#include <fstream>
+#include <vector>
+#include <string>
+#include <chrono>
+#include <memory>
+#include <thread>
+#include <atomic>
+#include <algorithm>
+#include <unordered_set>
+#include "PlayerAI.h"
+#include "OpeningBook.h"
+
+using namespace std;
+
+struct BookPosition {
+    uint32_t board[3];
+    bool o_turn;
+    uint64_t key;
+};
+
+PlayerAI playerAI(0, 0, 0);
+
+// every distinct position reached within the given number of plies from the start
+vector<BookPosition> collect_positions(int plies)
+{
+    BookPosition start = { { 4293918720, 4095, 0 }, true, 0 };
+    start.key = TranspositionTable::hash(start.board, start.o_turn);
+
+    vector<BookPosition> positions = { start };
+    unordered_set<uint64_t> seen = { start.key };
+
+    size_t first = 0;
+    for (int ply = 0; ply < plies; ply++)
+    {
+        size_t last = positions.size();
+        for (size_t i = first; i < last; i++)
+        {
+            MoveList moves;
+            BookPosition pos = positions[i];
+            playerAI.generate_moves(pos.board, pos.o_turn, moves);
+
+            for (uint32_t move : moves)
+            {
+                BookPosition next;
+                playerAI.apply_move(pos.board, next.board, move, pos.o_turn);
+                next.o_turn = !pos.o_turn;
+                next.key = TranspositionTable::hash(next.board, next.o_turn);
+
+                if (seen.insert(next.key).second)
+                    positions.push_back(next);
+            }
+        }
+        first = last;
+    }
+
+    return positions;
+}
+
+int main(int argc, char* argv[])
+{
+    const int plies = (argc > 1) ? stoi(argv[1]) : 4;
+    const int depth = (argc > 2) ? stoi(argv[2]) : 15;
+    const string path = (argc > 3) ? argv[3] : "opening.book";
+    const size_t table_mb = (argc > 4) ? stoul(argv[4]) : 256;
+    const int threads = max(1u, thread::hardware_concurrency());
+
+    vector<BookPosition> positions = collect_positions(plies);
+    vector<OpeningBook::Entry> entries(positions.size());
+    cout << positions.size() << " positions within " << plies << " plies, searching to depth " << depth
+         << " on " << threads << " threads" << endl;
+
+    // each worker takes the next position with its own engine. They share one table like the lazy smp helpers do,
+    // since positions a few plies apart lead into the same trees
+    shared_ptr<TranspositionTable> table = make_shared<TranspositionTable>(table_mb);
+    atomic<size_t> next_index { 0 };
+    auto start = chrono::steady_clock::now();
+    auto worker = [&]()
+    {
+        unique_ptr<PlayerAI> engine(new PlayerAI(0, 0, 0, table));
+        engine->set_limits({ depth, 0, 0 });
+
+        for (size_t i = next_index++; i < positions.size(); i = next_index++)
+        {
+            const BookPosition& pos = positions[i];
+            engine->next_move(!pos.o_turn, pos.board[1], pos.board[0], pos.board[2], false, false);
+            entries[i] = { pos.key, engine->last_move(), engine->last_score() };
+        }
+    };
+
+    vector<thread> workers;
+    for (int i = 0; i < threads; i++)
+        workers.emplace_back(worker);
+    for (thread& t : workers)
+        t.join();
+
+    cout << "searched in " << chrono::duration<double>(chrono::steady_clock::now() - start).count() << " s" << endl;
+
+    // positions without a legal move have nothing to store
+    entries.erase(remove_if(entries.begin(), entries.end(), [](const OpeningBook::Entry& e) { return !e.move; }), entries.end());
+    sort(entries.begin(), entries.end(), [](const OpeningBook::Entry& a, const OpeningBook::Entry& b) { return a.key < b.key; });
+
+    ofstream file(path, ios::binary);
+    if (!file)
+    {
+        cout << "cannot write " << path << endl;
+        return 1;
+    }
+
+    OpeningBook::Header header = {};
+    copy(OpeningBook::MAGIC, OpeningBook::MAGIC + sizeof(OpeningBook::MAGIC), header.magic);
+    header.count = entries.size();
+    file.write((const char*)&header, sizeof(header));
+    file.write((const char*)entries.data(), entries.size() * sizeof(OpeningBook::Entry));
+
+    cout << "wrote " << entries.size() << " entries to " << path << endl;
+    return file ? 0 : 1;
+}
@@ -0,0 +1,317 @@
+#include <iostream>
+#include <fstream>
+#include <vector>
+#include <string>
+#include <chrono>
+#include <memory>
+#include "PlayerAI.h"
+#include "EndgameDB.h"
+
+using namespace std;
+
+// longest distance tracked while solving, longer results are clamped when written
+const int MAX_DISTANCE = 1024;
+
+enum PositionState : uint8_t { INVALID, UNKNOWN, WIN_CLAIMED, LOSS_CLAIMED, WON, LOST };
+
+struct SliceData {
+    int x_men, x_kings, o_men, o_kings;
+    uint64_t positions;
+    vector<uint8_t> values;
+};
+
+PlayerAI playerAI(0, 0, 0);
+SliceData* solved[MAX_EG_PIECES + 1][MAX_EG_PIECES + 1][MAX_EG_PIECES + 1][MAX_EG_PIECES + 1];
+
+// return 0 if the square is off the board
+uint32_t neighbour(uint32_t pos, bool left, bool up)
+{
+    return shift(pos, left, up);
+}
+
+uint32_t unrank(uint64_t rank, int count, int offset)
+{
+    uint32_t squares = 0;
+    for (int i = count; i > 0; i--)
+    {
+        int square = i - 1;
+        while (EndgameDB::choose(square + 1, i) <= rank)
+            square++;
+
+        rank -= EndgameDB::choose(square, i);
+        squares |= 1u << (square + offset);
+    }
+
+    return squares;
+}
+
+// inverse of EndgameDB::position_index, false if two groups of pieces share a square
+bool unrank_position(const SliceData& slice, uint64_t index, uint32_t board[])
+{
+    const uint64_t o_kings_count = EndgameDB::choose(32, slice.o_kings);
+    const uint64_t o_men_count = EndgameDB::choose(28, slice.o_men);
+    const uint64_t x_kings_count = EndgameDB::choose(32, slice.x_kings);
+
+    uint32_t o_kings = unrank(index % o_kings_count, slice.o_kings, 0);
+    index /= o_kings_count;
+    uint32_t o_men = unrank(index % o_men_count, slice.o_men, 0);
+    index /= o_men_count;
+    uint32_t x_kings = unrank(index % x_kings_count, slice.x_kings, 0);
+    index /= x_kings_count;
+    uint32_t x_men = unrank(index, slice.x_men, 4);
+
+    board[0] = x_men | x_kings;
+    board[1] = o_men | o_kings;
+    board[2] = x_kings | o_kings;
+
+    return __builtin_popcount(board[0] | board[1]) == slice.x_men + slice.x_kings + slice.o_men + slice.o_kings;
+}
+
+bool in_slice(const SliceData& slice, const uint32_t board[])
+{
+    return __builtin_popcount(board[0] & ~board[2]) == slice.x_men && __builtin_popcount(board[0] & board[2]) == slice.x_kings &&
+           __builtin_popcount(board[1] & ~board[2]) == slice.o_men && __builtin_popcount(board[1] & board[2]) == slice.o_kings;
+}
+
+// value of a position from a smaller or already solved slice, a side without pieces has lost
+uint8_t lookup(const uint32_t board[], bool is_o)
+{
+    if (!board[is_o])
+        return EndgameDB::encode(EG_LOSS, 0);
+
+    const SliceData* slice = solved[__builtin_popcount(board[0] & ~board[2])][__builtin_popcount(board[0] & board[2])]
+                                   [__builtin_popcount(board[1] & ~board[2])][__builtin_popcount(board[1] & board[2])];
+
+    return slice->values[is_o * slice->positions + EndgameDB::position_index(board)];
+}
+
+// positions one quiet move earlier, made by the side that is not to move, that stay in the slice
+int predecessors(const uint32_t board[], bool is_o, uint32_t previous[][3])
+{
+    const bool mover = !is_o;
+    const uint32_t empty = ~(board[0] | board[1]);
+    int count = 0;
+
+    for (uint32_t pieces = board[mover]; pieces; pieces &= pieces - 1)
+    {
+        const uint32_t to = pieces & -pieces;
+        const bool is_king = to & board[2];
+
+        for (int dir = 0; dir < 4; dir++)
+        {
+            bool left = dir & 1, up = dir & 2;
+
+            // o men move up the board and x men down it, so they came from the other way
+            if (!is_king && up == mover)
+                continue;
+
+            uint32_t from = neighbour(to, left, up);
+            if (!(from & empty))
+                continue;
+
+            copy(board, board + 3, previous[count]);
+            previous[count][mover] ^= to | from;
+            if (is_king)
+                previous[count][2] ^= to | from;
+            count++;
+        }
+    }
+
+    return count;
+}
+
+// retrograde analysis of one slice: positions are settled one distance at a time, a position is won
+// once any move reaches a lost one and lost once every move reaches a won one, whatever is left is a draw
+void solve(SliceData& slice)
+{
+    const uint64_t total = 2 * slice.positions;
+
+    vector<uint8_t> state(total, INVALID);
+    vector<uint16_t> distance(total, 0), longest_loss(total, 0);
+    vector<uint8_t> unsettled(total, 0), can_draw(total, 0);
+    vector<vector<uint32_t>> pending(MAX_DISTANCE + 1);
+
+    MoveList moves;
+    for (uint64_t index = 0; index < total; index++)
+    {
+        uint32_t board[3];
+        const bool is_o = index >= slice.positions;
+        if (!unrank_position(slice, index % slice.positions, board))
+            continue;
+
+        state[index] = UNKNOWN;
+        playerAI.generate_moves(board, is_o, moves);
+
+        int shortest_win = MAX_DISTANCE + 1;
+        for (uint32_t move : moves)
+        {
+            uint32_t new_board[3];
+            playerAI.apply_move(board, new_board, move, is_o);
+
+            if (in_slice(slice, new_board))
+            {
+                unsettled[index]++;
+                continue;
+            }
+
+            int child_distance;
+            EGResult result = EndgameDB::decode(lookup(new_board, !is_o), child_distance);
+            if (result == EG_LOSS)
+                shortest_win = min(shortest_win, child_distance + 1);
+            else if (result == EG_WIN)
+                longest_loss[index] = max<int>(longest_loss[index], child_distance + 1);
+            else
+                can_draw[index] = true;
+        }
+
+        if (shortest_win <= MAX_DISTANCE)
+        {
+            state[index] = WIN_CLAIMED;
+            distance[index] = shortest_win;
+            pending[shortest_win].push_back(index);
+        }
+        else if (!unsettled[index] && !can_draw[index])
+        {
+            state[index] = LOSS_CLAIMED;
+            distance[index] = longest_loss[index];
+            pending[distance[index]].push_back(index);
+        }
+    }
+
+    uint32_t previous[4 * MAX_EG_PIECES][3];
+    for (int level = 0; level <= MAX_DISTANCE; level++)
+    {
+        for (size_t i = 0; i < pending[level].size(); i++)
+        {
+            const uint64_t index = pending[level][i];
+            if (distance[index] != level || (state[index] != WIN_CLAIMED && state[index] != LOSS_CLAIMED))
+                continue;
+
+            const bool won = state[index] == WIN_CLAIMED;
+            state[index] = won ? WON : LOST;
+
+            uint32_t board[3];
+            const bool is_o = index >= slice.positions;
+            unrank_position(slice, index % slice.positions, board);
+
+            const int count = predecessors(board, is_o, previous);
+            for (int j = 0; j < count; j++)
+            {
+                const uint64_t parent = (!is_o) * slice.positions + EndgameDB::position_index(previous[j]);
+                if (state[parent] != UNKNOWN && state[parent] != WIN_CLAIMED)
+                    continue;
+
+                if (!won)
+                {
+                    if (level < MAX_DISTANCE && (state[parent] == UNKNOWN || distance[parent] > level + 1))
+                    {
+                        state[parent] = WIN_CLAIMED;
+                        distance[parent] = level + 1;
+                        pending[level + 1].push_back(parent);
+                    }
+                }
+                else
+                {
+                    unsettled[parent]--;
+                    longest_loss[parent] = max<int>(longest_loss[parent], level + 1);
+
+                    if (state[parent] == UNKNOWN && !unsettled[parent] && !can_draw[parent] && longest_loss[parent] <= MAX_DISTANCE)
+                    {
+                        state[parent] = LOSS_CLAIMED;
+                        distance[parent] = longest_loss[parent];
+                        pending[distance[parent]].push_back(parent);
+                    }
+                }
+            }
+        }
+
+        vector<uint32_t>().swap(pending[level]);
+    }
+
+    slice.values.assign(total, 0);
+    for (uint64_t index = 0; index < total; index++)
+        if (state[index] == WON || state[index] == LOST)
+            slice.values[index] = EndgameDB::encode(state[index] == WON ? EG_WIN : EG_LOSS, distance[index]);
+}
+
+// EndgameGen [max pieces] [output file]
+int main(int argc, char* argv[])
+{
+    const int max_pieces = (argc > 1) ? stoi(argv[1]) : 4;
+    const string path = (argc > 2) ? argv[2] : "endgame.db";
+
+    if (max_pieces < 2 || max_pieces > MAX_EG_PIECES)
+    {
+        cout << "max pieces should be between 2 and " << MAX_EG_PIECES << endl;
+        return 1;
+    }
+
+    playerAI.set_hash_size(1);
+
+    // captures lead to fewer pieces and crowning to fewer men, so those slices are solved first
+    vector<unique_ptr<SliceData>> slices;
+    for (int total = 2; total <= max_pieces; total++)
+        for (int men = 0; men <= total; men++)
+            for (int x_men = 0; x_men <= men; x_men++)
+                for (int x_kings = 0; x_kings <= total - men; x_kings++)
+                {
+                    const int o_men = men - x_men, o_kings = total - men - x_kings;
+                    if (!(x_men + x_kings) || !(o_men + o_kings))
+                        continue;
+
+                    SliceData* slice = new SliceData { x_men, x_kings, o_men, o_kings,
+                                                       EndgameDB::slice_positions(x_men, x_kings, o_men, o_kings), {} };
+                    slices.emplace_back(slice);
+
+                    auto start = chrono::steady_clock::now();
+                    solve(*slice);
+                    solved[x_men][x_kings][o_men][o_kings] = slice;
+
+                    uint64_t wins = 0, losses = 0;
+                    for (uint8_t value : slice->values)
+                    {
+                        int distance;
+                        EGResult result = EndgameDB::decode(value, distance);
+                        wins += result == EG_WIN;
+                        losses += result == EG_LOSS && value;
+                    }
+
+                    cout << "x " << x_men << "m" << x_kings << "k vs o " << o_men << "m" << o_kings << "k: "
+                         << 2 * slice->positions << " positions, " << wins << " wins, " << losses << " losses, "
+                         << chrono::duration<double>(chrono::steady_clock::now() - start).count() << " s" << endl;
+                }
+
+    ofstream file(path, ios::binary);
+    if (!file)
+    {
+        cout << "cannot write " << path << endl;
+        return 1;
+    }
+
+    EndgameDB::Header header = {};
+    copy(EndgameDB::MAGIC, EndgameDB::MAGIC + sizeof(EndgameDB::MAGIC), header.magic);
+    header.max_pieces = max_pieces;
+    header.slice_count = slices.size();
+    file.write((const char*)&header, sizeof(header));
+
+    uint64_t offset = sizeof(header) + slices.size() * sizeof(EndgameDB::Slice);
+    for (const auto& slice : slices)
+    {
+        EndgameDB::Slice entry = {};
+        entry.x_men = slice->x_men;
+        entry.x_kings = slice->x_kings;
+        entry.o_men = slice->o_men;
+        entry.o_kings = slice->o_kings;
+        entry.offset = offset;
+        entry.positions = slice->positions;
+        file.write((const char*)&entry, sizeof(entry));
+
+        offset += slice->values.size();
+    }
+
+    for (const auto& slice : slices)
+        file.write((const char*)slice->values.data(), slice->values.size());
+
+    cout << "wrote " << offset << " bytes to " << path << endl;
+    return file ? 0 : 1;
+}
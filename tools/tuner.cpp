@@ -0,0 +1,188 @@
+#include <iostream>
+#include <fstream>
+#include <vector>
+#include <string>
+#include <chrono>
+#include <memory>
+#include <thread>
+#include <cmath>
+#include <algorithm>
+#include "PlayerAI.h"
+#include "Evaluation.h"
+#include "TrainingData.h"
+
+using namespace std;
+
+// the weights being tuned, in the order of the features below
+#define WEIGHT_COUNT 6
+
+int EvalWeights::* const TUNED[WEIGHT_COUNT] = {
+    &EvalWeights::man, &EvalWeights::king, &EvalWeights::back_rank,
+    &EvalWeights::center, &EvalWeights::advance, &EvalWeights::king_mobility
+};
+
+// the evaluation is linear in its weights, so a position is reduced once to what each weight counts in it
+// and every later score is a dot product
+struct TuningPosition {
+    int features[WEIGHT_COUNT];
+    float result;
+};
+
+PlayerAI playerAI(0, 0, 0);
+
+// quiet positions only, a capture that is about to happen is not something a static score can see
+vector<TuningPosition> load_positions(const TrainingData& data)
+{
+    Evaluation unit[WEIGHT_COUNT];
+    for (int i = 0; i < WEIGHT_COUNT; i++)
+    {
+        EvalWeights weights;
+        for (int j = 0; j < WEIGHT_COUNT; j++)
+            weights.*TUNED[j] = (i == j);
+        unit[i].set_weights(weights);
+    }
+
+    vector<TuningPosition> positions;
+    positions.reserve(data.size());
+    for (const TrainingRecord& record : data)
+    {
+        uint32_t board[3] = { record.board[0], record.board[1], record.board[2] };
+        MoveList moves;
+        playerAI.generate_moves(board, record.is_o, moves);
+        if (any_of(moves.begin(), moves.end(), [&](uint32_t move) { return move & board[!record.is_o]; }))
+            continue;
+
+        TuningPosition pos;
+        for (int i = 0; i < WEIGHT_COUNT; i++)
+            pos.features[i] = unit[i].score(board) + unit[i].mobility(board);
+        pos.result = (record.result + 1) / 2.0f;
+        positions.push_back(pos);
+    }
+
+    return positions;
+}
+
+// mean squared difference between the results and the win chance the scores predict, split over all cores
+double error(const vector<TuningPosition>& positions, const EvalWeights& weights, double k, int threads)
+{
+    int w[WEIGHT_COUNT];
+    for (int i = 0; i < WEIGHT_COUNT; i++)
+        w[i] = weights.*TUNED[i];
+
+    vector<double> sums(threads, 0);
+    vector<thread> workers;
+    for (int t = 0; t < threads; t++)
+    {
+        workers.emplace_back([&, t]()
+        {
+            double sum = 0;
+            for (size_t i = t; i < positions.size(); i += threads)
+            {
+                const TuningPosition& pos = positions[i];
+                int score = 0;
+                for (int j = 0; j < WEIGHT_COUNT; j++)
+                    score += w[j] * pos.features[j];
+
+                double predicted = 1 / (1 + exp(-k * score / 100.0));
+                sum += (pos.result - predicted) * (pos.result - predicted);
+            }
+            sums[t] = sum;
+        });
+    }
+    for (thread& worker : workers)
+        worker.join();
+
+    double sum = 0;
+    for (double s : sums)
+        sum += s;
+    return sum / max<size_t>(positions.size(), 1);
+}
+
+// the scale that turns points into a win chance is fitted once for the starting weights and then kept
+double fit_scale(const vector<TuningPosition>& positions, const EvalWeights& weights, int threads)
+{
+    double low = 0.01, high = 10;
+    for (int i = 0; i < 40; i++)
+    {
+        double a = low + (high - low) / 3, b = high - (high - low) / 3;
+        if (error(positions, weights, a, threads) < error(positions, weights, b, threads))
+            high = b;
+        else
+            low = a;
+    }
+
+    return (low + high) / 2;
+}
+
+// tuner [training file] [weights file], starts from the weights file if it exists and writes the result back to it
+int main(int argc, char* argv[])
+{
+    const string data_path = (argc > 1) ? argv[1] : "training.bin";
+    const string weights_path = (argc > 2) ? argv[2] : "eval.weights";
+    const int threads = max(1u, thread::hardware_concurrency());
+
+    TrainingData data;
+    if (!data.open(data_path))
+    {
+        cout << "cannot read " << data_path << endl;
+        return 1;
+    }
+
+    // the defaults are only for a first run, a weights file that is there but can't be read is not overwritten
+    EvalWeights weights;
+    if (!ifstream(weights_path))
+        cout << "no " << weights_path << ", starting from the default weights" << endl;
+    else if (!Evaluation::load_weights(weights_path, weights))
+    {
+        cout << "cannot read " << weights_path << endl;
+        return 1;
+    }
+
+    auto start = chrono::steady_clock::now();
+    vector<TuningPosition> positions = load_positions(data);
+    cout << positions.size() << " quiet positions of " << data.size() << ", tuning on " << threads << " threads" << endl;
+
+    const double k = fit_scale(positions, weights, threads);
+    double best = error(positions, weights, k, threads);
+    cout << "scale " << k << ", error " << best << endl;
+
+    // one weight at a time up or down while that lowers the error, then the same with smaller steps
+    for (int step = 16; step >= 1; step /= 2)
+    {
+        bool improved = true;
+        while (improved)
+        {
+            improved = false;
+            for (int i = 0; i < WEIGHT_COUNT; i++)
+            {
+                for (int sign : { 1, -1 })
+                {
+                    EvalWeights candidate = weights;
+                    candidate.*TUNED[i] += sign * step;
+
+                    double candidate_error = error(positions, candidate, k, threads);
+                    if (candidate_error < best)
+                    {
+                        best = candidate_error;
+                        weights = candidate;
+                        improved = true;
+                        break;
+                    }
+                }
+            }
+        }
+
+        cout << "step " << step << ", error " << best << endl;
+    }
+
+    cout << "tuned in " << chrono::duration<double>(chrono::steady_clock::now() - start).count() << " s" << endl;
+
+    if (!Evaluation::save_weights(weights_path, weights))
+    {
+        cout << "cannot write " << weights_path << endl;
+        return 1;
+    }
+
+    cout << "wrote " << weights_path << endl;
+    return 0;
+}